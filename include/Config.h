@@ -15,4 +15,59 @@
  */
 static constexpr int kMaxBlockSize = SAFE_MAX_BLOCK_SIZE;
 
+/**
+ * @brief Set to 1 to run the DSP benchmarks (DaisyBenchmark.cpp) once at startup,
+ * before audio starts. Results are printed over the serial log.
+ */
+#define DAISYTAPE_BENCHMARK 0
+
+/**
+ * @brief Set to 1 to build the N-band CrossoverEngine (DaisyCrossover.h). No stage of
+ * TapeProcessor uses it yet, so it stays out of the firmware (its align lines and band
+ * scratch take ~24 kB); the DAISYTAPE_BENCHMARK build measures it when enabled.
+ */
+#define DAISYTAPE_CROSSOVER 0
+
+/**
+ * @brief Per-module opt-in for the DaisyFastMath.h approximations (1) instead of libm (0).
+ * All of these run on the main thread; see DaisyFastMath.h for the error bounds.
+ * Off until the DAISYTAPE_BENCHMARK accuracy checks have passed on the target.
+ */
+#define DAISYTAPE_FASTMATH_LOSS     0   // LossFilter FIR design
+#define DAISYTAPE_FASTMATH_DEGRADE  0   // DegradeProcessor parameter cooking
+#define DAISYTAPE_FASTMATH_FILTERS  0   // Linkwitz-Riley cutoff prewarp (input filters)
+#define DAISYTAPE_FASTMATH_CONTROLS 0   // Pot to parameter mapping in DaisyTape.cpp
+
+/**
+ * @brief Set to 1 to place the audio-rate state in DTCM and processBlock() code in
+ * ITCM (DaisyMemory.h). 0 leaves everything where the linker script puts it.
+ */
+#define DAISYTAPE_TCM_PLACEMENT 1
+
+/**
+ * @brief Bytes of DTCM the TapeProcessor instance may take with DAISYTAPE_TCM_PLACEMENT.
+ * The main stack grows down from the top of the same 128 kB: half of it stays free.
+ */
+#define DAISYTAPE_DTCM_BUDGET (64 * 1024)
+
+/**
+ * @brief Set to 1 to stream per-block binary telemetry (DaisyTelemetry.h) over the
+ * serial log instead of the formatted status lines. Decode on the host with
+ * tools/telemetry_decode.py.
+ */
+#define DAISYTAPE_TELEMETRY 0
+
+/**
+ * @brief Samples between two control polls in the audio interrupt (staged parameter
+ * sets, latency compensation). At small block sizes these fixed costs would otherwise
+ * run every callback; parameters arrive at the ~100 Hz control rate, so polling every
+ * 32 samples (0.7 ms) adds no audible delay. 0 polls every block.
+ * benchBlockSizes on the host (x86_64 -O2, median of 15 runs, ns per callback, every
+ * block / every 32 samples): block 1: 820 / 739, 2: 1433 / 1400, 4: 2308 / 2238,
+ * 8: 4057 / 4073, 16: 7688 / 7515, 32: 14590 / 14354. Runs spread by up to +-9%, so
+ * only block 1 gains beyond the noise there. No Seed cycle counts yet: the
+ * DAISYTAPE_BENCHMARK build prints the same table, and those decide the interval.
+ */
+#define DAISYTAPE_CONTROL_INTERVAL 32
+
 #endif // DAISYTAPE_CONFIG_H
\ No newline at end of file
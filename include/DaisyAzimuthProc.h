@@ -2,26 +2,52 @@
 #ifndef DAISY_AZIMUTHPROC_H
 #define DAISY_AZIMUTHPROC_H
 
+#include "Config.h"
 #include "daisy_seed.h"
 #include "daisysp.h"
+#include "DaisyMailbox.h"
 #include <cmath>
 #include <algorithm>
 
-// 2^18 = 262,144 samples (~1MB per channel)
-#define AZIMUTH_DELAY_SIZE 262144
+// Head azimuth error range (degrees, either direction). Larger angles are clamped. A
+// misaligned head is off by minutes of arc; 1 degree already delays 4.4 ms at 1 ips
+#define AZIMUTH_MAX_ANGLE_DEG 1.0f
+// Slowest tape speed the delay ring is sized for (the speed pot bottoms out at 1 ips):
+// the tape takes longest to cover the tilt. Slower speeds are clamped
+#define AZIMUTH_MIN_SPEED_IPS 1.0f
+// Highest sample rate the delay ring is sized for
+#define AZIMUTH_MAX_SAMPLE_RATE 96000
+
+namespace azimuth {
+    constexpr float inches2meters(float inches) { return inches / 39.370078740157f; }
+
+    // 0.25 inches width converted to meters
+    constexpr float tapeWidth = inches2meters(0.25f);
+
+    // Offset = tilt / speed. sin(a) <= a bounds it without a constexpr sin; +1 for the
+    // DelayLine read offset and 4 more for the Hermite neighbours
+    constexpr int maxDelaySamples = (int)(tapeWidth * (AZIMUTH_MAX_ANGLE_DEG * (float)M_PI / 180.0f)
+                                          / inches2meters(AZIMUTH_MIN_SPEED_IPS) * AZIMUTH_MAX_SAMPLE_RATE) + 5;
+
+    constexpr int nextPow2(int v, int p = 1) { return p >= v ? p : nextPow2(v, p * 2); }
+}
+
+// Ring size: smallest power of two holding the largest offset (512 samples, 2kB per channel)
+#define AZIMUTH_DELAY_SIZE (azimuth::nextPow2(azimuth::maxDelaySamples))
 
-// Define the type for the SDRAM object so main.cpp can use it
 using AzimuthDelayLine = daisysp::DelayLine<float, AZIMUTH_DELAY_SIZE>;
 
 /**
  * Simple One-Pole Smoother for delay time transitions.
+ * Process() steps it per sample; ProcessBlock() steps it once per block, for
+ * callers that ramp linearly between the block start and end values.
  */
 class AzimuthSmoother {
 public:
     void Init(float sample_rate, float time_sec) {
         coeff_ = 1.0f / (time_sec * sample_rate);
         if (coeff_ > 1.0f) coeff_ = 1.0f;
-        
+
         current_ = 0.0f;
         target_ = 0.0f;
     }
@@ -46,6 +72,18 @@ public:
         return current_;
     }
 
+    // One step of numSamples: coeff * numSamples approximates 1 - (1 - coeff)^numSamples
+    // (within 1% up to blocks of 1/50 the time constant, 48 samples at 50 ms)
+    inline float ProcessBlock(int numSamples) {
+        float diff = target_ - current_;
+        if (std::abs(diff) < 1e-4f) {
+            current_ = target_;
+        } else {
+            current_ += diff * std::min(coeff_ * (float)numSamples, 1.0f);
+        }
+        return current_;
+    }
+
     float GetCurrent() const { return current_; }
 
 private:
@@ -55,29 +93,65 @@ private:
 };
 
 
+/**
+ * @brief Playback head azimuth error: one channel is delayed against the other by
+ * the time the tape needs to cover the tilt of the head gap across the track.
+ * The offset is at most AZIMUTH_DELAY_SIZE samples, so the delay lines are members
+ * and stay in internal SRAM with the rest of the processor. Whether that is cheaper
+ * than the former SDRAM lines on the Seed is for benchAzimuth to show; on the host
+ * both cost the same.
+ * The delay is smoothed at block rate and ramped linearly inside the block. Once it
+ * has settled, an integer delay is a plain read (or a copy for the undelayed channel,
+ * which sits at exactly 1.0) and only a fractional one pays for the Hermite read.
+ */
 class AzimuthProc
 {
 public:
-    AzimuthProc() {}
+    AzimuthProc();
     ~AzimuthProc() {}
 
     void prepare(float sampleRate);
-    
-    // Link SDRAM objects
-    void setDelayLinePointers(AzimuthDelayLine* delayL, AzimuthDelayLine* delayR);
 
-    void setAzimuthAngle(float angleDeg, float tapeSpeedIps);
-    
+    // Called from main thread: stage a new angle (degrees, < 0 delays left) and tape speed (ips)
+    void prepareParams(float angleDeg, float tapeSpeedIps, bool enabled);
+    // Called from main thread: posts a staged update the interrupt hasn't taken yet
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
+
     void processBlock(float* inL, float* inR, float* outL, float* outR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return onOff; }
 
 private:
+    struct CookedParams
+    {
+        bool onOff;
+        float targetDelay[2];   // DelayLine read positions (1.0 = no delay)
+    };
+
+    CookedParams cook() const;
+    void install(const CookedParams& c);
+
+    void processChannel(int ch, const float* in, float* out, int32_t blockSize);
+
     float fs;
-    
-    // Pointers to SDRAM delay lines
-    AzimuthDelayLine* delays[2];
-    
+
+    // Live values — written only from interrupt (via applyParams)
+    bool onOff;
+
+    // Requested values — main thread only
+    float req_angleDeg, req_speedIps;
+    bool req_onOff;
+    bool requestDirty;
+
+    CoefMailbox<CookedParams> mailbox;
+
+    // Delay lines (internal SRAM)
+    AzimuthDelayLine delays[2];
+
     // Smoothers
     AzimuthSmoother delaySampSmooth[2];
 };
 
-#endif // DAISY_AZIMUTHPROC_H
\ No newline at end of file
+#endif // DAISY_AZIMUTHPROC_H
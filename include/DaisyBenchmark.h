@@ -0,0 +1,20 @@
+#pragma once
+#ifndef DAISY_BENCHMARK_H
+#define DAISY_BENCHMARK_H
+
+#include "Config.h"
+#include "TapeProcessor.h"
+
+/**
+ * @brief On-target micro benchmarks for the DSP modules.
+ * Only run when DAISYTAPE_BENCHMARK is set in Config.h: main() calls this once,
+ * before audio starts, and the results are printed over the serial log.
+ * Costs are reported in CPU cycles per sample (ns per sample on host builds).
+ * At 48 kHz the Daisy Seed has 10000 cycles per sample in total.
+ * `processor` is the firmware's own instance (its delay lines fill most of the SDRAM),
+ * used for the whole-callback figures and re-initialised with `params` afterwards.
+ * Accuracy checks with a stated bound print FAIL when missed; returns how many did.
+ */
+int runBenchmarks(float sampleRate, TapeProcessor& processor, const TapeParams& params);
+
+#endif // DAISY_BENCHMARK_H
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef DAISY_CHEW_H
+#define DAISY_CHEW_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include "DaisyDegrade.h"   // LinSmoothed
+#include "DaisyRandomEvents.h"
+#include <cmath>
+#include <cstdint>
+
+// Chewed-tape cutoff at depth 0 and 1 (log interpolated), and level loss at depth 1
+#define CHEW_MAX_CUTOFF_HZ 12000.0f
+#define CHEW_MIN_CUTOFF_HZ 1200.0f
+#define CHEW_MAX_DIP_DB 6.0f
+
+// Mean time between bursts at freq 0 and 1 (log interpolated), mean burst length
+#define CHEW_MAX_GAP_S 3.0f
+#define CHEW_MIN_GAP_S 0.15f
+#define CHEW_BURST_S 0.12f
+
+// Fade in / out of a burst, also the shortest gap or burst. Wait before asking
+// again when the worker hasn't delivered the next event
+#define CHEW_RAMP_MS 10.0f
+#define CHEW_HOLD_SAMPLES 256
+
+/**
+ * @brief Chew: random bursts of high frequency loss and a small level dip, like a
+ * crinkled stretch of tape passing the head.
+ * The timing is a RandomEvents sequence (a clean gap, then a chewed burst); this
+ * class draws the burst's filter and level and runs the DSP.
+ * Estimated budget (stereo, of the 10000 cycles per sample at 48 kHz), not measured
+ * on the Seed yet:
+ * - clean and settled (most of the time): the block is left untouched, a counter
+ *   update and a few compares per block, under 5 cycles/sample at block 4
+ * - chewed or fading: one-pole lowpass and smoothed mix per channel, 8 flops for
+ *   the pair, ~15 cycles/sample
+ * so the stage can stay enabled. The DAISYTAPE_BENCHMARK build prints the measured
+ * idle and busy cost.
+ */
+class ChewProcessor
+{
+public:
+    ChewProcessor();
+    ~ChewProcessor() {}
+
+    void prepare(float sampleRate);
+
+    // Called from main thread: stage new parameters (all 0..1)
+    void prepareParams(float depth, float freq, float variance, bool enabled);
+    // Called from main thread (control rate): retries the flags, keeps the next event drawn
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
+
+    void processBlock(float* bufferL, float* bufferR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return events.isActive(); }
+
+private:
+    // One chew: clean tape for `gap` samples, then chewed for `length` (0: none)
+    struct Event
+    {
+        int32_t gap;
+        int32_t length;
+        float lpCoef[2];    // One-pole coefficient per channel
+        float level;        // Gain on the chewed signal
+    };
+
+    void drawBurst(Event& e);
+    void processRun(float* bufferL, float* bufferR, int32_t numSamples);
+
+    RandomEvents<Event> events;
+
+    // Live values — written only from interrupt
+    Event burst;            // Filter and level in use (kept through the fade-out)
+    LinSmoothed mix;
+    float lp[2];
+};
+
+#endif // DAISY_CHEW_H
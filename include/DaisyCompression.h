@@ -0,0 +1,98 @@
+#pragma once
+#ifndef DAISY_COMPRESSION_H
+#define DAISY_COMPRESSION_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include "DaisyDegrade.h"   // ChowLevelDetector
+#include "DaisyMailbox.h"
+#include "DaisyFastMath.h"
+#include <cmath>
+#include <cstdint>
+
+// Floor for the detector level, keeps log2 away from 0 (about -180 dB)
+#define COMP_LEVEL_FLOOR 1.0e-9f
+
+/**
+ * @brief Tape-style compression with a per-sample, stereo-linked gain computer.
+ * The envelope follower is a ChowLevelDetector (same attack/release one-pole as
+ * the degrade envelope). The gain computer runs in the log2 domain with
+ * polynomial log2/exp2 approximations, so the per-sample cost is a handful of
+ * multiply-adds with no library calls and no branches.
+ * No lookahead: the stage adds zero latency.
+ */
+class CompressionProcessor
+{
+public:
+    CompressionProcessor();
+    ~CompressionProcessor() {}
+
+    void prepare(float sampleRate);
+
+    // Called from main thread: stage new parameters (coefficients are computed here)
+    void prepareParams(float amount, float attackMs, float releaseMs, bool enabled);
+    // Called from main thread: posts a staged update the interrupt hasn't taken yet
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
+
+    void processBlock(float* bufferL, float* bufferR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return onOff; }
+
+    /**
+     * @brief Per-sample form of processBlock() for fused chains (DaisyStageChain.h).
+     * Only while isActive().
+     */
+    inline void processSample(float& l, float& r)
+    {
+        const float x = (std::fabs(l) + std::fabs(r)) * 0.5f;
+        const float level = std::fmax(levelDetector.processSample(x), COMP_LEVEL_FLOOR);
+        const float xLog2 = FastMath::log2(level);
+
+        // Branchless soft-knee gain computer:
+        // below knee -> 0, inside knee -> quadratic, above knee -> slope * (x - thresh)
+        const float overKnee = std::fmin(std::fmax(xLog2 - threshLog2 + halfKnee, 0.0f), kneeLog2);
+        const float overThresh = std::fmax(xLog2 - threshLog2 - halfKnee, 0.0f);
+        const float gainLog2 = kneeScale * overKnee * overKnee + slope * overThresh + makeupLog2;
+
+        const float g = FastMath::exp2(gainLog2);
+        l *= g;
+        r *= g;
+    }
+
+    float getLatencySamples() const { return 0.0f; }
+
+private:
+    struct CookedParams
+    {
+        bool onOff;
+        // Gain computer, all in log2 units (1 unit = 6.02 dB)
+        float threshLog2;     // Threshold
+        float kneeLog2;       // Knee width
+        float slope;          // (1/ratio - 1)
+        float makeupLog2;     // Output makeup
+        float tauAtt, tauRel; // Level detector time constants
+    };
+
+    CookedParams cook() const;
+    void install(const CookedParams& c);
+
+    float fs;
+
+    // Live values — written only from interrupt (via applyParams)
+    volatile bool onOff;
+    float threshLog2, kneeLog2, slope, makeupLog2;
+    float halfKnee, kneeScale;  // Derived from the above in install()
+
+    // Requested values — main thread only
+    float req_amount, req_attackMs, req_releaseMs;
+    bool req_onOff;
+    bool requestDirty;
+
+    CoefMailbox<CookedParams> mailbox;
+
+    ChowLevelDetector levelDetector;
+};
+
+#endif // DAISY_COMPRESSION_H
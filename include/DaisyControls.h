@@ -0,0 +1,60 @@
+#pragma once
+#ifndef DAISY_CONTROLS_H
+#define DAISY_CONTROLS_H
+
+#include <cmath>
+
+// One-pole smoothing per control tick (~35 ms time constant at the 100 Hz control rate)
+#define CONTROL_POT_SMOOTHING 0.25f
+// Smallest move (fraction of the pot travel) that counts as a change. The Seed ADC
+// jitters by about 0.1% on a still pot, so this sits just above it.
+#define CONTROL_POT_HYSTERESIS 0.002f
+
+/**
+ * @brief Potentiometer conditioning for the control loop (main thread only).
+ * The raw ADC value is smoothed by a one-pole, then passed through a hysteresis
+ * band: the stable value only follows once the smoothed one has moved more than
+ * CONTROL_POT_HYSTERESIS away from it. A pot that isn't touched therefore reports
+ * no change at all, so the mapping and restaging behind it don't run.
+ * The ends of the travel snap to exactly 0 and 1.
+ */
+class PotInput
+{
+public:
+    PotInput() : smoothed(0.0f), value(0.0f) {}
+
+    /** Starts at `raw` without a glide (first reading at startup). */
+    void init(float raw)
+    {
+        smoothed = raw;
+        value = snapEnds(raw);
+    }
+
+    /** Feeds one ADC reading; returns true when the stable value changed. */
+    bool process(float raw)
+    {
+        smoothed += CONTROL_POT_SMOOTHING * (raw - smoothed);
+
+        const float next = snapEnds(smoothed);
+        if (next == value || (std::fabs(next - value) < CONTROL_POT_HYSTERESIS && next != 0.0f && next != 1.0f))
+            return false;
+
+        value = next;
+        return true;
+    }
+
+    float getValue() const { return value; }
+
+private:
+    static float snapEnds(float v)
+    {
+        if (v < CONTROL_POT_HYSTERESIS) return 0.0f;
+        if (v > 1.0f - CONTROL_POT_HYSTERESIS) return 1.0f;
+        return v;
+    }
+
+    float smoothed;
+    float value;
+};
+
+#endif // DAISY_CONTROLS_H
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef DAISY_CROSSOVER_H
+#define DAISY_CROSSOVER_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include "daisysp.h" // For daisysp::DelayLine
+#include "DaisyLinkwitzRiley.h"
+#include "DaisyMailbox.h"
+#include <cstdint>
+
+// Maximum number of bands (and so MAX - 1 crossover frequencies)
+#define XOVER_MAX_BANDS 4
+// Compensation allpasses needed by the tree: (N - 1)(N - 2) / 2
+#define XOVER_MAX_ALLPASSES ((XOVER_MAX_BANDS - 1) * (XOVER_MAX_BANDS - 2) / 2)
+// Per-band latency alignment line (SRAM). Must exceed the largest latency difference
+// between bands, e.g. wow/flutter (~210 samples at 48 kHz) + loss FIR (35 samples).
+#define XOVER_ALIGN_SIZE 512
+
+using CrossoverAlignLine = daisysp::DelayLine<float, XOVER_ALIGN_SIZE>;
+
+/**
+ * @brief N-band (2..XOVER_MAX_BANDS) Linkwitz-Riley crossover with allpass compensation.
+ *
+ * Tree: the input goes through crossover 0; its high output feeds crossover 1 and so on,
+ * so band b is the low output of crossover b (the last band is the last high output).
+ * Band b then runs through the allpasses of crossovers b+1 .. N-2 that it skipped,
+ * which makes the unprocessed sum of all bands a flat-magnitude allpass.
+ *
+ * Block API (interrupt):
+ *   split(in)                 -> fills the shared band scratch buffers
+ *   bandL(b) / bandR(b)       -> process each band in place (any per-band chain)
+ *   setBandLatency(b, lat)    -> report what that chain added
+ *   sum(out)                  -> aligns every band to the slowest one and adds them up
+ *
+ * Cost per sample (stereo), in units of one stereo LR4 step (C_lr) and one stereo
+ * allpass (C_ap ~ C_lr / 2):  split = (N - 1) C_lr + (N - 1)(N - 2) / 2 C_ap,
+ * sum = N aligned delay reads. The DAISYTAPE_BENCHMARK build prints the measured
+ * cycles per band for N = 2 .. XOVER_MAX_BANDS.
+ * Only compiled with DAISYTAPE_CROSSOVER (Config.h): not wired into TapeProcessor yet.
+ */
+class CrossoverEngine
+{
+public:
+    CrossoverEngine();
+    ~CrossoverEngine() {}
+
+    void prepare(float sampleRate);
+
+    // Called from main thread: stage a new split. crossoverHz holds numBands - 1
+    // ascending frequencies. Coefficients are computed here.
+    void prepareParams(int numBands, const float* crossoverHz);
+    // Called from main thread: posts a staged update the interrupt hasn't taken yet
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only)
+    void applyParams();
+
+    void split(const float* inL, const float* inR, int32_t blockSize);
+
+    float* bandL(int band) { return scratch[band][0]; }
+    float* bandR(int band) { return scratch[band][1]; }
+
+    /** Latency (samples, may be fractional) the band's processing added since split(). */
+    void setBandLatency(int band, float latencySamples);
+
+    void sum(float* outL, float* outR, int32_t blockSize);
+
+    int getNumBands() const { return numBands; }
+    /** Latency of the summed output relative to the input (the slowest band). */
+    float getLatencySamples() const { return maxLatency; }
+    /** True once a band needed more alignment than XOVER_ALIGN_SIZE holds: the line was
+     *  clamped and that band is summed early. Sticky until prepare(). */
+    bool wasAlignmentClamped() const { return alignClamped; }
+
+private:
+    struct StagedParams
+    {
+        int numBands;
+        float hz[XOVER_MAX_BANDS - 1];
+        float g[XOVER_MAX_BANDS - 1];
+        float h[XOVER_MAX_BANDS - 1];
+    };
+
+    // Index of the allpass that compensates band `band` for crossover `xover` (xover > band)
+    static int allpassIndex(int band, int xover) { return xover * (xover - 1) / 2 + band; }
+
+    void cookRequest();
+    void updateAlignment();
+
+    float fs;
+    int numBands;
+
+    // Requested values — main thread only
+    int reqNumBands;
+    float reqHz[XOVER_MAX_BANDS - 1];
+    StagedParams request;
+    bool requestDirty;
+    CoefMailbox<StagedParams> mailbox;
+
+    LinkwitzRileyFilter<float> crossovers[XOVER_MAX_BANDS - 1];
+    LinkwitzRileyAllpass<float> allpasses[XOVER_MAX_ALLPASSES];
+
+    float bandLatency[XOVER_MAX_BANDS];
+    float maxLatency;
+    bool alignClamped;
+    CrossoverAlignLine align[XOVER_MAX_BANDS][2];
+
+    // Band buffers, shared by all engines: everything runs in the one audio interrupt
+    static float scratch[XOVER_MAX_BANDS][2][SAFE_MAX_BLOCK_SIZE];
+};
+
+#endif // DAISY_CROSSOVER_H
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef DAISY_CYCLECOUNTER_H
+#define DAISY_CYCLECOUNTER_H
+
+#include <cstdint>
+
+#if defined(__arm__)
+#include "daisy_seed.h"
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief Thin wrapper around the Cortex-M7 DWT cycle counter.
+ * On the Daisy Seed (480 MHz) one audio sample at 48 kHz is worth 10000 cycles.
+ * On host builds the counter falls back to steady_clock nanoseconds, so the
+ * same benchmark code reports ns instead of cycles.
+ */
+class CycleCounter
+{
+public:
+    static void Init()
+    {
+#if defined(__arm__)
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    }
+
+    static inline uint32_t Now()
+    {
+#if defined(__arm__)
+        return DWT->CYCCNT;
+#else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static inline const char* Unit()
+    {
+#if defined(__arm__)
+        return "cycles";
+#else
+        return "ns";
+#endif
+    }
+
+    // Counter rate, for turning counts into a share of the audio budget
+    static inline uint32_t PerSecond()
+    {
+#if defined(__arm__)
+        return SystemCoreClock;
+#else
+        return 1000000000u;
+#endif
+    }
+
+    // Unsigned subtraction handles a single counter wrap
+    static inline uint32_t Elapsed(uint32_t start) { return Now() - start; }
+};
+
+#endif // DAISY_CYCLECOUNTER_H
@@ -4,19 +4,82 @@
 
 #include "Config.h"
 #include "daisy_seed.h"
+#include "DaisyMailbox.h"
+#include "DaisyFastMath.h"
 #include <cmath>
 #include <vector>
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
 
+#if DAISYTAPE_FASTMATH_DEGRADE
+using DegradeMath = FastMath;
+#else
+using DegradeMath = StdMath;
+#endif
+
 // Internal Control Block Size (Modulation Rate)
 #define DEG_BLOCK_SIZE 2048
 
+// DegradeFilter cutoff glide length and coefficient table size (20 Hz .. 0.49 fs, log spaced)
+#define DEG_FILTER_SMOOTH_STEPS 200
+#define DEG_FILTER_LUT_SIZE 128
+
+// -------------------------------
+// 48-bit LCG jump-ahead
+// One LCG step is the affine map s -> (mul * s + add) mod 2^48, so n steps
+// compose into a single affine map that takes O(log n) multiplies to build.
+// -------------------------------
+struct LcgJump
+{
+    static constexpr uint64_t mask = 0xFFFFFFFFFFFFULL;
+    static constexpr uint64_t stepMul = 0x5deece66dULL;
+    static constexpr uint64_t stepAdd = 11ULL;
+
+    uint64_t mul = 1ULL;
+    uint64_t add = 0ULL;
+
+    inline uint64_t apply(uint64_t s) const noexcept { return (s * mul + add) & mask; }
+
+    /** Map for `first` followed by `second`. */
+    static LcgJump compose(const LcgJump& first, const LcgJump& second) noexcept
+    {
+        LcgJump r;
+        r.mul = (second.mul * first.mul) & mask;
+        r.add = (second.mul * first.add + second.add) & mask;
+        return r;
+    }
+
+    /** Map advancing the generator by n steps (square-and-multiply). */
+    static LcgJump steps(uint64_t n) noexcept
+    {
+        LcgJump result;
+        LcgJump power;
+        power.mul = stepMul;
+        power.add = stepAdd;
+        while (n > 0)
+        {
+            if (n & 1ULL) result = compose(result, power);
+            power = compose(power, power);
+            n >>= 1;
+        }
+        return result;
+    }
+
+    /** Converts a post-step LCG state to JuceRandom::nextFloat()'s value. */
+    static inline float toFloat(uint64_t s) noexcept
+    {
+        // (uint32_t)nextInt() is just the top 32 of the 48 bits. Dividing by 2^32 is exact as a multiply.
+        const float res = static_cast<float>(static_cast<std::uint32_t>(s >> 16)) * (1.0f / 4294967296.0f);
+        return res == 1.0f ? 1.0f - std::numeric_limits<float>::epsilon() : res;
+    }
+};
+
 // -------------------------------
 // JUCE-compatible 48-bit LCG Random
 // -------------------------------
@@ -50,85 +113,134 @@ public:
         return res;
     }
 
+    /** Advances the sequence by n values in O(log n). */
+    void skip(uint64_t n) noexcept
+    {
+        seed = (int64_t)LcgJump::steps(n).apply((uint64_t)seed);
+    }
+
 private:
     int64_t seed;
 };
 
 // -------------------------------
-// Linear smoothed value (For Gain)
-// Matches JUCE SmoothedValue<Linear> behavior
+// Multi-lane JuceRandom
+// Bit-exact with JuceRandom (same seed -> same nextFloat() sequence), but lane i
+// holds sequence value i of the next group of `Lanes`, and every lane jumps by
+// `Lanes` steps at once. The lanes are independent, so a refill is a plain
+// vectorisable loop instead of one serial 48-bit multiply chain.
 // -------------------------------
-class LinSmoothed
+template <int Lanes>
+class JuceRandomLanes
 {
+    static_assert(Lanes > 0 && (Lanes & (Lanes - 1)) == 0, "Lanes must be a power of two");
+
 public:
-    LinSmoothed(float initial = 0.0f) noexcept
+    JuceRandomLanes(uint64_t seed = 1ull) noexcept
     {
-        current = target = initial;
-        stepsToTarget = 0;
-        step = 0.0f;
+        setSeed(seed);
     }
 
-    void reset(int numSteps)
+    void setSeed(uint64_t newSeed) noexcept
     {
-        stepsToTarget = numSteps;
-        setCurrentAndTargetValue(target);
+        uint64_t s = newSeed & LcgJump::mask;
+        for (int i = 0; i < Lanes; ++i)
+        {
+            s = (s * LcgJump::stepMul + LcgJump::stepAdd) & LcgJump::mask;
+            state[i] = s;
+        }
+        groupJump = LcgJump::steps(Lanes);
+        cachePos = Lanes;
     }
 
-    void setCurrentAndTargetValue(float v)
+    inline float nextFloat() noexcept
     {
-        target = current = v;
-        stepsToTarget = 0;
-        step = 0.0f;
+        if (cachePos == Lanes) refill();
+        return cache[cachePos++];
     }
 
-    void setTargetValue(float newValue)
+    /** Writes the next numSamples values of the sequence to out. */
+    void fillFloats(float* out, int numSamples) noexcept
     {
-        if (newValue == target) return;
-        if (stepsToTarget <= 0)
+        int n = 0;
+
+        // Drain what's left of the current group
+        while (cachePos < Lanes && n < numSamples)
+            out[n++] = cache[cachePos++];
+
+        // Whole groups straight from the lanes
+        for (; n + Lanes <= numSamples; n += Lanes)
         {
-            setCurrentAndTargetValue(newValue);
-            return;
+            for (int i = 0; i < Lanes; ++i)
+            {
+                out[n + i] = LcgJump::toFloat(state[i]);
+                state[i] = groupJump.apply(state[i]);
+            }
         }
-        target = newValue;
-        countdown = stepsToTarget;
-        // Linear step calculation
-        step = (target - current) / (float)countdown;
+
+        // Tail goes through the cache
+        while (n < numSamples)
+            out[n++] = nextFloat();
     }
 
-    bool isSmoothing() const noexcept { return countdown > 0; }
+    /** Advances the sequence by n values in O(log n). */
+    void skip(uint64_t n) noexcept
+    {
+        while (cachePos < Lanes && n > 0)
+        {
+            ++cachePos;
+            --n;
+        }
 
-    float getCurrentValue() const noexcept { return current; }
+        const uint64_t groups = n / Lanes;
+        if (groups > 0)
+        {
+            const LcgJump jump = LcgJump::steps(groups * Lanes);
+            for (int i = 0; i < Lanes; ++i)
+                state[i] = jump.apply(state[i]);
+        }
 
-    float getNextValue() noexcept
-    {
-        if (!isSmoothing()) return target;
-        --countdown;
-        if (countdown > 0)
-            current += step;
-        else
-            current = target;
-        return current;
+        const int rest = (int)(n % Lanes);
+        if (rest > 0)
+        {
+            refill();
+            cachePos = rest;
+        }
     }
 
-    void setSteps(int s) { stepsToTarget = s; countdown = 0; }
-
 private:
-    float current, target, step;
-    int stepsToTarget, countdown;
+    inline void refill() noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+        {
+            cache[i] = LcgJump::toFloat(state[i]);
+            state[i] = groupJump.apply(state[i]);
+        }
+        cachePos = 0;
+    }
+
+    uint64_t state[Lanes];  // Post-step LCG state of each value in the next group
+    float cache[Lanes];
+    int cachePos;
+    LcgJump groupJump;      // Advances a lane by `Lanes` steps
 };
 
+// Lane count used by the audio-rate noise generators
+#define DEG_RNG_LANES 8
+
 // -------------------------------
-// Multiplicative smoothed value (For Freq)
-// Matches JUCE SmoothedValue<Multiplicative> behavior
+// Linear smoothed value (For Gain)
+// Matches JUCE SmoothedValue<Linear> behavior
 // -------------------------------
-class MulSmoothed
+class LinSmoothed
 {
 public:
-    MulSmoothed(float initial = 1.0f) noexcept
+    LinSmoothed(float initial = 0.0f) noexcept
     {
         current = target = initial;
         stepsToTarget = 0;
-        step = 1.0f;
+        countdown = 0;
+        step = 0.0f;
     }
 
     void reset(int numSteps)
@@ -137,11 +249,12 @@ public:
         setCurrentAndTargetValue(target);
     }
 
+    // Ends any ramp; the ramp length (reset / setSteps) is kept, as in JUCE
     void setCurrentAndTargetValue(float v)
     {
         target = current = v;
-        stepsToTarget = 0;
-        step = 1.0f;
+        countdown = 0;
+        step = 0.0f;
     }
 
     void setTargetValue(float newValue)
@@ -154,7 +267,8 @@ public:
         }
         target = newValue;
         countdown = stepsToTarget;
-        step = std::exp((std::log(std::abs(target)) - std::log(std::abs(current))) / (float)countdown);
+        // Linear step calculation
+        step = (target - current) / (float)countdown;
     }
 
     bool isSmoothing() const noexcept { return countdown > 0; }
@@ -166,7 +280,7 @@ public:
         if (!isSmoothing()) return target;
         --countdown;
         if (countdown > 0)
-            current *= step;
+            current += step;
         else
             current = target;
         return current;
@@ -199,25 +313,37 @@ public:
         tauRel = calcTimeConstant(releaseMs, expFactor);
     }
 
+    /** Installs time constants precomputed with calcTimeConstant() (no exp). */
+    void setTimeConstants(float newTauAtt, float newTauRel) noexcept
+    {
+        tauAtt = newTauAtt;
+        tauRel = newTauRel;
+    }
+
+    /** One-pole coefficient for a time in ms; expFactorLocal = -1000 / fs. */
+    static inline float calcTimeConstant(float timeMs, float expFactorLocal)
+    {
+        return timeMs < 1.0e-3f ? 0.0f : 1.0f - DegradeMath::exp(expFactorLocal / timeMs);
+    }
+
     void process(const float* inL, const float* inR, float* outLevel, int numSamples, int numChannels)
     {
         if (numChannels == 1)
         {
-            for (int i = 0; i < numSamples; ++i)
-                absBuf[i] = std::fabs(inL[i]);
+            for (int n = 0; n < numSamples; ++n)
+                outLevel[n] = processSample(std::fabs(inL[n]));
         }
         else
         {
-            for (int i = 0; i < numSamples; ++i)
-            {
-                float a0 = std::fabs(inL[i]);
-                float a1 = std::fabs(inR[i]);
-                absBuf[i] = (a0 + a1) * 0.5f; 
-            }
+            for (int n = 0; n < numSamples; ++n)
+                outLevel[n] = processSample(stereoInput(inL[n], inR[n]));
         }
+    }
 
-        for (int n = 0; n < numSamples; ++n)
-            outLevel[n] = processSample(absBuf[n]);
+    /** Detector input for a stereo pair (mean of the absolute values). */
+    static inline float stereoInput(float l, float r) noexcept
+    {
+        return (std::fabs(l) + std::fabs(r)) * 0.5f;
     }
 
     inline float processSample(float x) noexcept
@@ -230,17 +356,11 @@ public:
     }
 
 private:
-    inline float calcTimeConstant(float timeMs, float expFactorLocal)
-    {
-        return timeMs < 1.0e-3f ? 0.0f : 1.0f - std::exp(expFactorLocal / timeMs);
-    }
-
     float fs = 48000.0f;
     float expFactor = -1000.0f;
     float tauAtt = 1.0f, tauRel = 1.0f;
     float yOld = 0.0f;
     bool increasing = true;
-    float absBuf[SAFE_MAX_BLOCK_SIZE];      // Changed from DRG_BLOCK_SIZE to SAFE_MAX_BLOCK_SIZE
 };
 
 // -------------------------------
@@ -261,27 +381,53 @@ public:
 
     void processBlock(float* buffer, int numSamples)
     {
+        float r[noiseChunk];
+        for (int start = 0; start < numSamples; start += noiseChunk)
+        {
+            const int end = std::min(start + noiseChunk, numSamples);
+            fillSamples(r, start, end, numSamples);
+            for (int n = start; n < end; ++n)
+                buffer[n] += r[n - start];
+        }
+        endBlock();
+    }
+
+    /**
+     * Chunk form of processBlock() for fused kernels: writes the noise processBlock()
+     * would add at indices start..end-1 (at most noiseChunk) to out[0..end-start-1].
+     * Call over 0..numSamples-1 in order, then endBlock().
+     */
+    inline void fillSamples(float* out, int start, int end, int numSamples) noexcept
+    {
+        // Uniform values come in chunks from the multi-lane generator, the gain maths stays per sample
+        const int len = end - start;
+        rng.fillFloats(out, len);
+
         if (curGain == prevGain)
         {
-            for (int n = 0; n < numSamples; ++n)
-                buffer[n] += (rng.nextFloat() - 0.5f) * curGain;
+            for (int i = 0; i < len; ++i)
+                out[i] = (out[i] - 0.5f) * curGain;
         }
         else
         {
-            for (int n = 0; n < numSamples; ++n)
+            for (int i = 0; i < len; ++i)
             {
+                const int n = start + i;
                 float alpha = (numSamples > 1) ? (float)n / (float)numSamples : 1.0f;
                 float g = curGain * alpha + prevGain * (1.0f - alpha);
-                buffer[n] += (rng.nextFloat() - 0.5f) * g;
+                out[i] = (out[i] - 0.5f) * g;
             }
-            prevGain = curGain;
         }
     }
 
+    void endBlock() noexcept { prevGain = curGain; }
+
     void seed(uint64_t s) { rng.setSeed(s); }
 
+    static constexpr int noiseChunk = 32;
+
 private:
-    JuceRandom rng;
+    JuceRandomLanes<DEG_RNG_LANES> rng;
     float curGain = 0.0f;
     float prevGain = 0.0f;
 };
@@ -301,46 +447,117 @@ public:
     {
         fs = sampleRate;
         z[0] = z[1] = 0.0f;
-        freqSm.setCurrentAndTargetValue(20000.0f);
-        freqSm.setSteps(200); 
-        calcCoefs(freqSm.getCurrentValue());
+        buildTable();
+        posCur = posTarget = freqToPos(20000.0f);
+        posStep = 0.0f;
+        countdown = 0;
+        setB0(lookup(posCur));
     }
 
     void setFreq(float newFreq)
     {
         if (newFreq <= 0.0f) newFreq = 20.0f;
-        freqSm.setTargetValue(newFreq);
+        setFreqPosition(freqToPos(newFreq));
+    }
+
+    /** Same as setFreq() with the frequency already mapped by freqToPos() (no log2 call). */
+    void setFreqPosition(float newPos)
+    {
+        if (newPos == posTarget) return;
+        posTarget = newPos;
+        countdown = DEG_FILTER_SMOOTH_STEPS;
+        posStep = (posTarget - posCur) * (1.0f / (float)DEG_FILTER_SMOOTH_STEPS);
+    }
+
+    /** Table position of a cutoff frequency (log2 domain, clamped to the table range). */
+    float freqToPos(float fc) const
+    {
+        float pos = (DegradeMath::log2(fc) - log2MinFreq) * posPerOctave;
+        return std::fmin(std::fmax(pos, 0.0f), (float)(DEG_FILTER_LUT_SIZE - 1));
     }
 
-    inline void calcCoefs(float fc)
+    /** Exact coefficients (tan) — reference for the table, not used per sample. */
+    static float calcB0(float fc, float sampleRate)
     {
-        float wc = 2.0f * M_PI * fc / fs;
+        float wc = 2.0f * M_PI * fc / sampleRate;
         float tanv = std::tan(wc * 0.5f);
-        float c = 1.0f / tanv;
-        float a0 = c + 1.0f;
+        return tanv / (tanv + 1.0f);
+    }
+
+    /** Samples left in the current frequency glide. */
+    int getSmoothingRemaining() const noexcept { return countdown; }
+
+    /** One sample while gliding: table lookup only, no tan. Caller guarantees getSmoothingRemaining() > 0. */
+    inline float processSampleSmoothing(float x) noexcept
+    {
+        if (--countdown > 0)
+            posCur += posStep;
+        else
+            posCur = posTarget;
+        setB0(lookup(posCur));
+        return processSampleSteady(x);
+    }
+
+    /** One sample with fixed coefficients. */
+    inline float processSampleSteady(float x) noexcept
+    {
+        float y = z[1] + x * b[0];
+        z[1] = x * b[1] - y * a[1];
+        return y;
+    }
 
-        b[0] = 1.0f / a0;
-        b[1] = b[0];
-        a[1] = (1.0f - c) / a0;
+    inline float processSample(float x) noexcept
+    {
+        return countdown > 0 ? processSampleSmoothing(x) : processSampleSteady(x);
     }
 
     inline void process(float* buffer, int numSamples)
     {
-        for (int n = 0; n < numSamples; ++n)
-        {
-            if (freqSm.isSmoothing())
-                calcCoefs(freqSm.getNextValue());
+        // Glide segment, then a branch-free steady segment
+        const int nSmooth = std::min(numSamples, countdown);
+        int n = 0;
+        for (; n < nSmooth; ++n)
+            buffer[n] = processSampleSmoothing(buffer[n]);
+        for (; n < numSamples; ++n)
+            buffer[n] = processSampleSteady(buffer[n]);
+    }
 
-            float x = buffer[n];
-            float y = z[1] + x * b[0];
-            z[1] = x * b[1] - y * a[1];
-            buffer[n] = y;
+private:
+    // b0 over log2(frequency), 20 Hz .. 0.49 fs. With the bilinear one-pole,
+    // b1 = b0 and a1 = 2 * b0 - 1, so one value per entry is enough.
+    void buildTable()
+    {
+        log2MinFreq = std::log2(20.0f);
+        const float log2MaxFreq = std::log2(0.49f * fs);
+        posPerOctave = (float)(DEG_FILTER_LUT_SIZE - 1) / (log2MaxFreq - log2MinFreq);
+
+        for (int i = 0; i < DEG_FILTER_LUT_SIZE; ++i)
+        {
+            const float fc = std::exp2(log2MinFreq + (float)i / posPerOctave);
+            b0Table[i] = calcB0(fc, fs);
         }
+        b0Table[DEG_FILTER_LUT_SIZE] = b0Table[DEG_FILTER_LUT_SIZE - 1];   // guard for the interpolation
+    }
+
+    inline float lookup(float pos) const noexcept
+    {
+        const int i = (int)pos;
+        const float frac = pos - (float)i;
+        return b0Table[i] + frac * (b0Table[i + 1] - b0Table[i]);
+    }
+
+    inline void setB0(float b0) noexcept
+    {
+        b[0] = b0;
+        b[1] = b0;
+        a[1] = 2.0f * b0 - 1.0f;
     }
 
-private:
     float fs;
-    MulSmoothed freqSm{20000.0f};
+    float log2MinFreq = 0.0f, posPerOctave = 1.0f;
+    float posCur = 0.0f, posTarget = 0.0f, posStep = 0.0f;
+    int countdown = 0;
+    float b0Table[DEG_FILTER_LUT_SIZE + 1];
     float a[2]{1.0f, 0.0f}, b[2]{1.0f, 0.0f}, z[2]{0.0f, 0.0f};
 };
 
@@ -358,37 +575,73 @@ public:
     // Called from main thread: stage new parameters
     void prepareParams(float depth, float amount, float variance, float envelope,
                        bool enabled, bool usePoint1x = false);
-    // Called from interrupt: apply staged parameters
-    void applyParams();
+    // Called from main thread (control rate): precomputes the next cooked parameter set
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
 
     void processBlock(float* inL, float* inR, int blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return onOff; }
+
+#if DAISYTAPE_BENCHMARK
+    // Pre-fusion form of processBlock(): one pass per step over scratch buffers, same
+    // cooking and state. Only the benchmark calls it, as the fused kernel's reference
+    void processBlockStaged(float* inL, float* inR, int blockSize);
+#endif
 
 private:
+    // Flags the interrupt switches on as soon as they change
+    struct LiveParams
+    {
+        bool onOff;
+        bool applyEnvelope;
+    };
+
+    // Everything cookParams() installs every DEG_BLOCK_SIZE samples, with all the
+    // pow / exp / log2 and random draws already done on the main thread
+    struct CookedParams
+    {
+        float noiseGain;
+        float filterPos[2];     // DegradeFilter table positions
+        float tauAtt, tauRel;   // Level detector time constants
+        float gainTarget;
+        uint32_t generation;    // reqGeneration it was cooked for
+    };
+
+    CookedParams cookNext();
     void cookParams();
+    // Splits a block at the DEG_BLOCK_SIZE cooking points, ShortBlock runs the pieces
+    template <void (DegradeProcessor::*ShortBlock)(float*, float*, int)>
+    void processCooking(float* inL, float* inR, int blockSize);
     void processShortBlock(float* chunkL, float* chunkR, int numSamples);
+#if DAISYTAPE_BENCHMARK
+    void processShortBlockStaged(float* chunkL, float* chunkR, int numSamples);
+#endif
+    template <bool SmoothL, bool SmoothR>
+    void processFused(float* chunkL, float* chunkR, int start, int end, int numSamples, bool applyEnvelope);
 
     float fs;
 
-    // Live values — written only from interrupt (via applyParams)
+    // Live values — written only from interrupt (via applyParams / cookParams)
     volatile bool onOff;
-    volatile bool usePoint1xFlag;
-    float p_depth, p_amount, p_variance, p_envelope;
+    bool applyEnvelope;
+    CookedParams cooked;
 
-    // Staged values — written from main, consumed by applyParams()
-    float pending_depth, pending_amount, pending_variance, pending_envelope;
-    bool pending_onOff, pending_usePoint1x;
-    volatile bool paramsDirty;
+    // Requested values — main thread only, read by the worker
+    float req_depth, req_amount, req_variance, req_envelope;
+    bool req_onOff, req_usePoint1x;
+    bool liveDirty;
+
+    CoefMailbox<LiveParams> liveBox;
+    CoefMailbox<CookedParams> cookBox;
+    volatile uint32_t reqGeneration;    // Main thread: bumped by every request; the interrupt drops sets cooked for an older one
 
     DegradeFilter filters[2];
     DegradeNoise noises[2];
     ChowLevelDetector levelDetector;
 
-    // Scratch buffers — sized to actual max block, not the modulation block size
-    float noiseBufL[SAFE_MAX_BLOCK_SIZE];       // These were also changed from DEG_BLOCK_SIZE to SAFE_MAX_BLOCK_SIZE
-    float noiseBufR[SAFE_MAX_BLOCK_SIZE];
-    float levelBuf[SAFE_MAX_BLOCK_SIZE];
-
-    JuceRandom paramRng;
+    JuceRandom paramRng;    // Main thread only (drawn by the worker)
     int sampleCounter;
     // --- CRITICAL FIX: Use Linear Smoother for Gain ---
     // This ensures gain changes ramp over a fixed duration (2048 samples)
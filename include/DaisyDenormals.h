@@ -0,0 +1,78 @@
+#pragma once
+#ifndef DAISY_DENORMALS_H
+#define DAISY_DENORMALS_H
+
+#include <cstdint>
+
+#if defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__)
+#include "daisy_seed.h"     // CMSIS: __get_FPSCR / __set_FPSCR, FPU->FPDSCR
+#define DAISYTAPE_HAS_FTZ 1
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define DAISYTAPE_HAS_FTZ 1
+#else
+#define DAISYTAPE_HAS_FTZ 0
+#endif
+
+/**
+ * @brief States below this magnitude (-180 dBFS) are cleared by the Linkwitz-Riley
+ * per-state snap. Everything else relies on ScopedFlushToZero: both targets have FTZ,
+ * and a build without it (DAISYTAPE_HAS_FTZ == 0) only runs slower on decaying tails.
+ */
+#define DENORMAL_SNAP_THRESHOLD 1.0e-9f
+
+/**
+ * @brief Flush-to-zero for the scope of a block (RAII), like JUCE's ScopedNoDenormals.
+ * - Cortex-M7: FPSCR.FZ (bit 24). Subnormal inputs and results become signed zero.
+ * - x86 host:  MXCSR FTZ (bit 15) + DAZ (bit 6); subnormals cost ~100x there.
+ * The previous mode is restored on exit, so nesting and callers outside the
+ * audio path are unaffected. Constructing with enable = false forces the mode off
+ * (used by the benchmark to measure the unguarded cost).
+ */
+class ScopedFlushToZero
+{
+public:
+    explicit ScopedFlushToZero(bool enable = true)
+    {
+#if DAISYTAPE_HAS_FTZ && defined(__arm__)
+        saved = __get_FPSCR();
+        __set_FPSCR(enable ? (saved | fpscrFZ) : (saved & ~fpscrFZ));
+#elif DAISYTAPE_HAS_FTZ
+        saved = _mm_getcsr();
+        _mm_setcsr(enable ? (saved | mxcsrFTZ_DAZ) : (saved & ~mxcsrFTZ_DAZ));
+#else
+        (void)enable;
+#endif
+    }
+
+    ~ScopedFlushToZero()
+    {
+#if DAISYTAPE_HAS_FTZ && defined(__arm__)
+        __set_FPSCR(saved);
+#elif DAISYTAPE_HAS_FTZ
+        _mm_setcsr(saved);
+#endif
+    }
+
+    ScopedFlushToZero(const ScopedFlushToZero&) = delete;
+    ScopedFlushToZero& operator=(const ScopedFlushToZero&) = delete;
+
+    /**
+     * Process-wide default: on the M7 an exception handler doesn't inherit the thread's
+     * FPSCR, it starts from FPDSCR. Setting FZ there makes every interrupt (the audio
+     * callback included) run flushed from its first instruction. Call once at startup.
+     */
+    static void enableForInterrupts()
+    {
+#if DAISYTAPE_HAS_FTZ && defined(__arm__)
+        FPU->FPDSCR |= fpscrFZ;
+#endif
+    }
+
+private:
+    static constexpr uint32_t fpscrFZ = 1u << 24;
+    static constexpr uint32_t mxcsrFTZ_DAZ = 0x8040u;
+    uint32_t saved = 0;
+};
+
+#endif // DAISY_DENORMALS_H
@@ -0,0 +1,131 @@
+#pragma once
+#ifndef DAISY_FASTMATH_H
+#define DAISY_FASTMATH_H
+
+#include "Config.h"
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Single-precision approximations for coefficient and control code.
+ * All functions are branch-light polynomials that map onto the M7 FPU (no libm
+ * calls, no double promotion). The error bounds below are measured over the
+ * stated domain against double-precision libm, including float rounding. The
+ * DAISYTAPE_BENCHMARK build sweeps each function over its domain (pow at y = 0.8,
+ * log2 / gainToDb over 1e-6..1e6), prints FAIL when a bound is exceeded, and times
+ * each one against StdMath.
+ *
+ * | function | domain                   | max error                  |
+ * |----------|--------------------------|----------------------------|
+ * | log2     | x > 0 (normal)           | 1.1e-5 absolute            |
+ * | exp2     | any (clamped to +-126)   | 2.8e-6 relative            |
+ * | exp      | |x| < 87                 | 6.5e-6 relative            |
+ * | pow      | x > 0                    | 5.5e-6 * (1 + |y|) relative|
+ * | dbToGain | |dB| < 700               | 5.6e-6 relative            |
+ * | gainToDb | g > 0 (normal)           | 6.5e-5 dB absolute         |
+ * | sin, cos | |x| < 8192               | 1.1e-6 absolute            |
+ * | tan      | |x| <= 1.52 (fc < 0.48fs)| 3.3e-6 relative            |
+ *
+ * Call sites opt in per module through the DAISYTAPE_FASTMATH_* switches in
+ * Config.h, selecting either FastMath or StdMath (same interface, libm). StdMath
+ * keeps double arguments in double; FastMath is float only.
+ */
+struct FastMath
+{
+    /** log2(x) for normal x > 0: exponent bits + degree-5 polynomial on the mantissa.
+     *  Exact at powers of two. */
+    static inline float log2(float x)
+    {
+        union { float f; uint32_t i; } v = { x };
+        const float e = (float)((int32_t)(v.i >> 23) - 127);
+        v.i = (v.i & 0x007FFFFFu) | 0x3F800000u;
+        const float t = v.f - 1.0f;
+        return e + t * (1.442683252f + (-0.7204423702f + (0.4693016859f + (-0.3033896644f
+                     + (0.1464336114f - 0.03459520998f * t) * t) * t) * t) * t);
+    }
+
+    /** 2^x: integer part into the exponent bits + degree-4 polynomial on the fraction. */
+    static inline float exp2(float x)
+    {
+        x = std::fmin(std::fmax(x, -126.0f), 126.0f);
+        int32_t xi = (int32_t)x;
+        xi -= (x < (float)xi) ? 1 : 0;      // floor without a library call
+        const float f = x - (float)xi;
+        union { float f; uint32_t i; } v;
+        v.f = 1.000002518f + (0.6930066207f + (0.2414274933f + (0.05203742877f + 0.0135206032f * f) * f) * f) * f;
+        v.i += (uint32_t)xi << 23;
+        return v.f;
+    }
+
+    static inline float exp(float x) { return exp2(x * 1.442695041f); }
+
+    /** x^y for x > 0 (no negative bases). */
+    static inline float pow(float x, float y) { return exp2(y * log2(x)); }
+
+    static inline float dbToGain(float dB) { return exp2(dB * 0.1660964047f); }   // log2(10) / 20
+    static inline float gainToDb(float g) { return 6.020599913f * log2(g); }      // 20 / log2(10)
+
+    /** sin(x): reduction to [-pi/2, pi/2] (two-part pi) + odd degree-7 polynomial. */
+    static inline float sin(float x)
+    {
+        const int32_t q = roundToInt(x * invPi);
+        const float r = (x - (float)q * piHi) - (float)q * piLo;
+        const float s = sinPoly(r);
+        return (q & 1) ? -s : s;
+    }
+
+    /** cos(x) = -(-1)^k sin(r) with x = (k + 1/2) pi + r. */
+    static inline float cos(float x)
+    {
+        const int32_t k = roundToInt(x * invPi - 0.5f);
+        const float kh = (float)k + 0.5f;
+        const float r = (x - kh * piHi) - kh * piLo;
+        const float s = sinPoly(r);
+        return (k & 1) ? s : -s;
+    }
+
+    /** tan(x) for |x| < pi/2 (no range reduction): sin and cos polynomials and one divide. */
+    static inline float tan(float x)
+    {
+        const float x2 = x * x;
+        const float c = 0.9999999532f + (-0.4999990506f + (0.04166357893f + (-0.001385366693f
+                      + 2.315317416e-05f * x2) * x2) * x2) * x2;
+        return sinPoly(x) / c;
+    }
+
+    static inline float sqrt(float x) { return std::sqrt(x); }    // vsqrt.f32 on the M7
+
+private:
+    static constexpr float invPi = 0.3183098862f;
+    static constexpr float piHi = 3.140625f;            // exact in float, q * piHi is exact for |q| < 2^15
+    static constexpr float piLo = 9.676535897e-4f;
+
+    static inline int32_t roundToInt(float x) { return (int32_t)(x + (x >= 0.0f ? 0.5f : -0.5f)); }
+
+    // sin(r) for |r| <= pi/2
+    static inline float sinPoly(float r)
+    {
+        const float r2 = r * r;
+        return r * (0.9999990556f + (-0.1666555067f + (0.008311864934f - 0.0001848723209f * r2) * r2) * r2);
+    }
+};
+
+/**
+ * @brief libm reference with the FastMath interface. Templated so that double
+ * call sites keep their precision when a module doesn't opt in.
+ */
+struct StdMath
+{
+    template <typename T> static inline T log2(T x) { return std::log2(x); }
+    template <typename T> static inline T exp2(T x) { return std::exp2(x); }
+    template <typename T> static inline T exp(T x) { return std::exp(x); }
+    template <typename T> static inline T pow(T x, T y) { return std::pow(x, y); }
+    template <typename T> static inline T dbToGain(T dB) { return std::pow(T(10), dB / T(20)); }
+    template <typename T> static inline T gainToDb(T g) { return T(20) * std::log10(g); }
+    template <typename T> static inline T sin(T x) { return std::sin(x); }
+    template <typename T> static inline T cos(T x) { return std::cos(x); }
+    template <typename T> static inline T tan(T x) { return std::tan(x); }
+    template <typename T> static inline T sqrt(T x) { return std::sqrt(x); }
+};
+
+#endif // DAISY_FASTMATH_H
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef DAISY_GOVERNOR_H
+#define DAISY_GOVERNOR_H
+
+#include <cstdint>
+
+// Peak block load (share of the block period) above which the governor steps down a
+// tier, and below which it may step back up
+#define GOVERNOR_DOWN_LOAD 0.85f
+#define GOVERNOR_UP_LOAD 0.55f
+
+// In update() calls (~10 ms each from the control loop): consecutive calls over the down
+// threshold before stepping down, under the up threshold before stepping up, and calls
+// ignored after any change (the new tier's crossfades and redesigns run meanwhile)
+#define GOVERNOR_DOWN_CALLS 2
+#define GOVERNOR_UP_CALLS 300
+#define GOVERNOR_SETTLE_CALLS 20
+
+// Stepping down again within GOVERNOR_BOUNCE_CALLS of a step up doubles the wait before
+// the next step up, up to GOVERNOR_MAX_UP_CALLS (a load sitting between two tiers)
+#define GOVERNOR_BOUNCE_CALLS 500
+#define GOVERNOR_MAX_UP_CALLS 6000
+
+/**
+ * @brief Processing quality, from the parameters as set down to the cheapest settings
+ * that still sound like the same patch. Each tier caps the one before; what a tier
+ * changes is applied by TapeProcessor::setQualityTier(), through each module's own
+ * click-free update path:
+ * - Reduced: hysteresis solver at most RK4 (NR4 is the costliest stage by far).
+ * - Economy: hysteresis RK2, loss filter FIR replaced by its IIR fit at the same
+ *   latency (LossFilterMode::IIRAligned), wow/flutter Hermite read replaced by linear.
+ */
+enum class QualityTier : int
+{
+    Full = 0,
+    Reduced,
+    Economy,
+    NumTiers
+};
+
+/**
+ * @brief CPU governor: picks the quality tier from the measured audio load.
+ * Fed once per control loop tick with the worst block since the last tick
+ * (TapeProcessor::takePeakLoad()). Steps down one tier as soon as the peak stays over
+ * GOVERNOR_DOWN_LOAD, back up one tier only after a long stretch under
+ * GOVERNOR_UP_LOAD, with a settling pause after every change and a growing wait when
+ * a step up has to be undone. Main thread only.
+ * Manual mode pins a tier (offline renders, measurements) and ignores the load.
+ */
+class CpuGovernor
+{
+public:
+    CpuGovernor();
+    ~CpuGovernor() {}
+
+    /** Back to automatic mode at full quality. */
+    void reset();
+
+    /** Pins `tier` until setAutomatic(). */
+    void setManualTier(QualityTier tier);
+    /** Hands the tier back to the load, starting from the current one. */
+    void setAutomatic();
+    bool isAutomatic() const { return automatic; }
+
+    /**
+     * @brief Once per control loop tick, with the peak block load since the last call
+     * (1 = a block took its whole period). True when the tier changed: pass
+     * getTier() to TapeProcessor::setQualityTier().
+     */
+    bool update(float peakLoad);
+
+    QualityTier getTier() const { return tier; }
+
+private:
+    void changeTier(int newTier);
+
+    QualityTier tier;
+    bool automatic;
+    bool changed;       // Tier set manually since the last update()
+
+    int settleCalls;    // Calls left to ignore
+    int overCalls;      // Consecutive calls over GOVERNOR_DOWN_LOAD
+    int underCalls;     // Consecutive calls under GOVERNOR_UP_LOAD
+    int upCalls;        // Calls under GOVERNOR_UP_LOAD needed to step up
+    int sinceStepUp;    // Calls since a step up that still holds (GOVERNOR_BOUNCE_CALLS: none)
+};
+
+#endif // DAISY_GOVERNOR_H
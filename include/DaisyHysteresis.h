@@ -0,0 +1,360 @@
+#pragma once
+#ifndef DAISY_HYSTERESIS_H
+#define DAISY_HYSTERESIS_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include "DaisyMailbox.h"
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Numerical solver used for the Jiles-Atherton differential equation.
+ * Cost is dominated by the number of hysteresisFunc evaluations per sample
+ * (each one a tanh and a few divides per channel). The counts below follow from
+ * the methods, they are not measurements: the DAISYTAPE_BENCHMARK build prints
+ * the measured cycles/sample on the target.
+ *
+ * - RK2: 2 evaluations  (cheapest, default)
+ * - RK4: 4 evaluations
+ * - NR4: 1 + 4 evaluations, 4 derivative evaluations (most accurate, implicit)
+ */
+enum class HysteresisSolver : int
+{
+    RK2 = 0,
+    RK4,
+    NR4,
+    NumSolvers
+};
+
+/**
+ * @brief Two-lane float used to run L and R through the solver together.
+ * Two plain scalars, not a vector type: the element-wise operators keep the solver
+ * readable as scalar maths and give the compiler two independent dependency chains
+ * to interleave.
+ */
+struct HystFloat2
+{
+    float v[2];
+
+    HystFloat2() = default;
+    HystFloat2(float x) : v{ x, x } {}
+    HystFloat2(float a, float b) : v{ a, b } {}
+
+    inline float& operator[](int i) { return v[i]; }
+    inline float operator[](int i) const { return v[i]; }
+};
+
+inline HystFloat2 operator+(HystFloat2 a, HystFloat2 b) { return { a.v[0] + b.v[0], a.v[1] + b.v[1] }; }
+inline HystFloat2 operator-(HystFloat2 a, HystFloat2 b) { return { a.v[0] - b.v[0], a.v[1] - b.v[1] }; }
+inline HystFloat2 operator*(HystFloat2 a, HystFloat2 b) { return { a.v[0] * b.v[0], a.v[1] * b.v[1] }; }
+inline HystFloat2 operator/(HystFloat2 a, HystFloat2 b) { return { a.v[0] / b.v[0], a.v[1] / b.v[1] }; }
+
+/**
+ * @brief Jiles-Atherton hysteresis core, ported from ChowTape's HysteresisProcessing.
+ * Works in single precision, so the Langevin functions switch to their Taylor
+ * series over a wider region around zero than the double-precision original.
+ */
+class HysteresisCore
+{
+public:
+    void prepare(float sampleRate);
+    void reset();
+
+    /** Model constants derived from the user parameters (see calcCoefs()). */
+    struct Coefs
+    {
+        float M_s, a, c, nc, oneOverA;
+        float M_s_oa, M_s_oa_talpha, M_s_oa_tc, M_s_oa_tc_talpha;
+        float M_s_oaSq_tc_talpha, M_s_oaSq_tc_talphaSq;
+    };
+
+    // Derives the model constants from the user parameters (all 0..1). Pure, safe off the audio thread.
+    static Coefs calcCoefs(float drive, float saturation, float width);
+    void setCoefs(const Coefs& co);
+
+    void cook(float drive, float saturation, float width) { setCoefs(calcCoefs(drive, saturation, width)); }
+
+    template <HysteresisSolver S>
+    void processBlock(float* bufferL, float* bufferR, int numSamples);
+
+    /** One stereo sample in place (the body of processBlock(), inline for fused chains). */
+    template <HysteresisSolver S>
+    inline void processSample(float& l, float& r);
+
+private:
+    // Below this |Q| the Langevin functions are evaluated from their Taylor series.
+    // The closed forms cancel catastrophically in float much closer to zero than in double.
+    static constexpr float langevinSeriesLim = 0.1f;
+
+    // Alpha-transform derivative coefficient (same as ChowTape)
+    static constexpr float dAlpha = 0.75f;
+
+    // Intermediate values shared between hysteresisFunc and hysteresisFuncPrime
+    struct FuncState
+    {
+        HystFloat2 Q, coth, M_diff, L_prime, kap1, f1Denom, f3, nearZero;
+    };
+
+    inline HystFloat2 deriv(HystFloat2 x_n, HystFloat2 x_n1, HystFloat2 x_d_n1) const;
+    inline HystFloat2 hysteresisFunc(HystFloat2 M, HystFloat2 H, HystFloat2 H_d, FuncState& st) const;
+    inline HystFloat2 hysteresisFuncPrime(HystFloat2 H_d, HystFloat2 dMdt, const FuncState& st) const;
+
+    inline HystFloat2 solveRK2(HystFloat2 H, HystFloat2 H_d) const;
+    inline HystFloat2 solveRK4(HystFloat2 H, HystFloat2 H_d) const;
+    inline HystFloat2 solveNR4(HystFloat2 H, HystFloat2 H_d) const;
+
+    float T = 1.0f / 48000.0f;
+    float Talpha = T / 1.9f;
+
+    // Model parameters
+    float M_s = 1.0f;
+    float a = M_s / 4.0f;
+    static constexpr float alpha = 1.6e-3f;
+    float k = 0.47875f;
+    float c = 1.7e-1f;
+    float upperLim = 20.0f;
+
+    // Pre-multiplied constants (see cook())
+    float nc = 1.0f - c;
+    float oneOverA = 1.0f / a;
+    float M_s_oa = M_s / a;
+    float M_s_oa_talpha = alpha * M_s_oa;
+    float M_s_oa_tc = c * M_s_oa;
+    float M_s_oa_tc_talpha = alpha * M_s_oa_tc;
+    float M_s_oaSq_tc_talpha = M_s_oa_tc_talpha / a;
+    float M_s_oaSq_tc_talphaSq = alpha * M_s_oaSq_tc_talpha;
+
+    // State (one lane per channel)
+    HystFloat2 M_n1{ 0.0f };
+    HystFloat2 H_n1{ 0.0f };
+    HystFloat2 H_d_n1{ 0.0f };
+};
+
+// Solver kernels, in the header so processSample() can be inlined into fused chains
+inline HystFloat2 HysteresisCore::deriv(HystFloat2 x_n, HystFloat2 x_n1, HystFloat2 x_d_n1) const
+{
+    const float gain = (1.0f + dAlpha) / T;
+    return HystFloat2(gain) * (x_n - x_n1) - HystFloat2(dAlpha) * x_d_n1;
+}
+
+inline HystFloat2 HysteresisCore::hysteresisFunc(HystFloat2 M, HystFloat2 H, HystFloat2 H_d, FuncState& st) const
+{
+    st.Q = (H + HystFloat2(alpha) * M) * HystFloat2(oneOverA);
+
+    HystFloat2 L;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const float Q = st.Q[ch];
+        const bool nearZero = std::fabs(Q) < langevinSeriesLim;
+        const float Qsafe = nearZero ? 1.0f : Q;     // keeps tanh/1/Q finite, result is discarded below
+        const float coth = 1.0f / std::tanh(Qsafe);
+        const float Q2 = Q * Q;
+
+        st.nearZero[ch] = nearZero ? 1.0f : 0.0f;
+        st.coth[ch] = coth;
+        L[ch] = nearZero ? Q * (1.0f / 3.0f - Q2 * (1.0f / 45.0f))
+                         : coth - 1.0f / Qsafe;
+        st.L_prime[ch] = nearZero ? 1.0f / 3.0f - Q2 * (1.0f / 15.0f)
+                                  : 1.0f / (Qsafe * Qsafe) - coth * coth + 1.0f;
+    }
+
+    st.M_diff = HystFloat2(M_s) * L - M;
+
+    HystFloat2 delta, delta_M;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        delta[ch] = (H_d[ch] >= 0.0f) ? 1.0f : -1.0f;
+        delta_M[ch] = ((H_d[ch] >= 0.0f) == (st.M_diff[ch] >= 0.0f)) ? 1.0f : 0.0f;
+    }
+
+    st.kap1 = HystFloat2(nc) * delta_M;
+    st.f1Denom = HystFloat2(nc * k) * delta - HystFloat2(alpha) * st.M_diff;
+
+    const HystFloat2 f1 = st.kap1 * st.M_diff / st.f1Denom;
+    const HystFloat2 f2 = HystFloat2(M_s_oa_tc) * st.L_prime;
+    st.f3 = HystFloat2(1.0f) - HystFloat2(M_s_oa_tc_talpha) * st.L_prime;
+
+    return H_d * (f1 + f2) / st.f3;
+}
+
+inline HystFloat2 HysteresisCore::hysteresisFuncPrime(HystFloat2 H_d, HystFloat2 dMdt, const FuncState& st) const
+{
+    HystFloat2 L_prime2;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const float Q = st.Q[ch];
+        const float coth = st.coth[ch];
+        const float Qsafe = (st.nearZero[ch] != 0.0f) ? 1.0f : Q;
+        L_prime2[ch] = (st.nearZero[ch] != 0.0f)
+                           ? Q * (-2.0f / 15.0f + Q * Q * (8.0f / 189.0f))
+                           : 2.0f * coth * (coth * coth - 1.0f) - 2.0f / (Qsafe * Qsafe * Qsafe);
+    }
+
+    const HystFloat2 M_diff2 = HystFloat2(M_s_oa_talpha) * st.L_prime - HystFloat2(1.0f);
+    const HystFloat2 f1_p = st.kap1 * ((M_diff2 / st.f1Denom)
+                          + st.M_diff * HystFloat2(alpha) * M_diff2 / (st.f1Denom * st.f1Denom));
+    const HystFloat2 f2_p = HystFloat2(M_s_oaSq_tc_talpha) * L_prime2;
+    const HystFloat2 f3_p = HystFloat2(-M_s_oaSq_tc_talphaSq) * L_prime2;
+
+    return H_d * (f1_p + f2_p) / st.f3 - dMdt * f3_p / st.f3;
+}
+
+inline HystFloat2 HysteresisCore::solveRK2(HystFloat2 H, HystFloat2 H_d) const
+{
+    FuncState st;
+    const HystFloat2 half(0.5f), Tv(T);
+
+    const HystFloat2 k1 = Tv * hysteresisFunc(M_n1, H_n1, H_d_n1, st);
+    const HystFloat2 k2 = Tv * hysteresisFunc(M_n1 + half * k1, half * (H + H_n1), half * (H_d + H_d_n1), st);
+
+    return M_n1 + k2;
+}
+
+inline HystFloat2 HysteresisCore::solveRK4(HystFloat2 H, HystFloat2 H_d) const
+{
+    FuncState st;
+    const HystFloat2 half(0.5f), Tv(T);
+    const HystFloat2 H_1_2 = half * (H + H_n1);
+    const HystFloat2 H_d_1_2 = half * (H_d + H_d_n1);
+
+    const HystFloat2 k1 = Tv * hysteresisFunc(M_n1, H_n1, H_d_n1, st);
+    const HystFloat2 k2 = Tv * hysteresisFunc(M_n1 + half * k1, H_1_2, H_d_1_2, st);
+    const HystFloat2 k3 = Tv * hysteresisFunc(M_n1 + half * k2, H_1_2, H_d_1_2, st);
+    const HystFloat2 k4 = Tv * hysteresisFunc(M_n1 + k3, H, H_d, st);
+
+    const HystFloat2 oneSixth(1.0f / 6.0f), oneThird(1.0f / 3.0f);
+    return M_n1 + oneSixth * k1 + oneThird * k2 + oneThird * k3 + oneSixth * k4;
+}
+
+inline HystFloat2 HysteresisCore::solveNR4(HystFloat2 H, HystFloat2 H_d) const
+{
+    FuncState st;
+    const HystFloat2 Ta(Talpha), one(1.0f);
+
+    HystFloat2 M = M_n1;
+    const HystFloat2 last_dMdt = hysteresisFunc(M_n1, H_n1, H_d_n1, st);
+
+    for (int n = 0; n < 4; ++n)
+    {
+        const HystFloat2 dMdt = hysteresisFunc(M, H, H_d, st);
+        const HystFloat2 dMdtPrime = hysteresisFuncPrime(H_d, dMdt, st);
+        const HystFloat2 deltaNR = (M - M_n1 - Ta * (dMdt + last_dMdt)) / (one - Ta * dMdtPrime);
+        M = M - deltaNR;
+    }
+
+    return M;
+}
+
+template <HysteresisSolver S>
+inline void HysteresisCore::processSample(float& l, float& r)
+{
+    HystFloat2 H(std::fmax(std::fmin(l, upperLim), -upperLim),
+                 std::fmax(std::fmin(r, upperLim), -upperLim));
+    HystFloat2 H_d = deriv(H, H_n1, H_d_n1);
+
+    HystFloat2 M;
+    if (S == HysteresisSolver::RK4)
+        M = solveRK4(H, H_d);
+    else if (S == HysteresisSolver::NR4)
+        M = solveNR4(H, H_d);
+    else
+        M = solveRK2(H, H_d);
+
+    // Instability check: a NaN or runaway lane is reset instead of latching up
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const bool illCondition = !(std::fabs(M[ch]) < upperLim);
+        M[ch] = illCondition ? 0.0f : M[ch];
+        H_d[ch] = illCondition ? 0.0f : H_d[ch];
+    }
+
+    M_n1 = M;
+    H_n1 = H;
+    H_d_n1 = H_d;
+
+    l = M[0];
+    r = M[1];
+}
+
+/**
+ * @brief Hysteresis stage: tape magnetisation nonlinearity.
+ * Runs at the base sample rate (no oversampling) with a DC blocker on the output.
+ */
+class HysteresisProcessor
+{
+public:
+    HysteresisProcessor();
+    ~HysteresisProcessor() {}
+
+    void prepare(float sampleRate);
+
+    // Called from main thread: stage new parameters (model constants are computed here)
+    void prepareParams(float drive, float saturation, float bias, bool enabled,
+                       HysteresisSolver solver = HysteresisSolver::RK2);
+    // Called from main thread: posts a staged update the interrupt hasn't taken yet
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
+
+    void processBlock(float* bufferL, float* bufferR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return onOff; }
+    HysteresisSolver getSolver() const { return solver; }
+
+    /**
+     * @brief Per-sample form of processBlock() for fused chains (DaisyStageChain.h):
+     * core, makeup and DC blocker on one stereo sample. Only while isActive() with
+     * solver S.
+     */
+    template <HysteresisSolver S>
+    inline void processSample(float& l, float& r)
+    {
+        core.processSample<S>(l, r);
+        l = dcBlock(0, l * makeup);
+        r = dcBlock(1, r * makeup);
+    }
+
+private:
+    struct CookedParams
+    {
+        bool onOff;
+        HysteresisSolver solver;
+        HysteresisCore::Coefs coefs;
+        float makeup;
+    };
+
+    CookedParams cook() const;
+    void install(const CookedParams& c);
+
+    float fs;
+
+    // Live values — written only from interrupt (via applyParams)
+    volatile bool onOff;
+    HysteresisSolver solver;
+    float makeup;
+
+    // Requested values — main thread only
+    float req_drive, req_saturation, req_bias;
+    bool req_onOff;
+    HysteresisSolver req_solver;
+    bool requestDirty;
+
+    CoefMailbox<CookedParams> mailbox;
+
+    HysteresisCore core;
+
+    // DC blocker (one-pole high-pass) state
+    float dcCoef;
+    float dcX1[2], dcY1[2];
+
+    inline float dcBlock(int ch, float x)
+    {
+        const float y = x - dcX1[ch] + dcCoef * dcY1[ch];
+        dcX1[ch] = x;
+        dcY1[ch] = y;
+        return y;
+    }
+};
+
+#endif // DAISY_HYSTERESIS_H
@@ -5,6 +5,8 @@
 #include "Config.h"
 #include "daisy_seed.h"
 #include "DaisyLinkwitzRiley.h"
+#include "DaisyLatencyTap.h"
+#include "DaisyMailbox.h"
 #include "daisysp.h" // For daisysp::DelayLine 
 #include <algorithm>
 #include <cmath>
@@ -17,6 +19,109 @@
 // The InputFilters class holds pointers to the globally allocated DelayLines.
 using MakeupDelayLine = daisysp::DelayLine<float, MAKEUP_DELAY_SIZE>;
 
+// Auto-bypass: a band is skipped where it is flat within INPUT_FILTERS_BYPASS_FLAT_DB
+// over 20 Hz .. 20 kHz, so switching it out is no audible step. For the LR4 bands that
+// is a low cut at or below ~6.6 Hz, a high cut at or above ~0.47 fs (22.7 kHz at 48 kHz,
+// capped at the 0.48 fs clamp); see InputFilters::prepare()
+#define INPUT_FILTERS_BYPASS_FLAT_DB 0.1f
+// Crossfade length between filtered and unfiltered audio (~5 ms at 48 kHz)
+#define INPUT_FILTERS_BYPASS_FADE 256
+// Samples a band runs on the live input (output still dry) before fading back in,
+// so the filter state has settled and the fade doesn't start from a zero state
+#define INPUT_FILTERS_BYPASS_WARMUP 2048
+// Cutoff changes glide over one control period (~10 ms at 48 kHz) instead of jumping
+#define INPUT_FILTERS_GLIDE_SAMPLES 480
+
+/**
+ * @brief Auto-bypass state machine for one filter band (shared by both channels).
+ * Active -> FadingOut -> Bypassed -> WarmingUp -> FadingIn -> Active.
+ * Interrupt only: setBypass() on parameter changes, advance() once per block.
+ */
+class FilterAutoBypass
+{
+public:
+    enum class State { Active, FadingOut, Bypassed, WarmingUp, FadingIn };
+
+    // Jump straight to a state (prepare time, no fade)
+    void init(bool bypass)
+    {
+        state = bypass ? State::Bypassed : State::Active;
+        counter = 0;
+        wet = startWet = bypass ? 0.0f : 1.0f;
+        stepPerSample = 0.0f;
+        running = !bypass;
+    }
+
+    // Returns true when the filter has been idle and its state must be cleared before warm-up
+    bool setBypass(bool bypass)
+    {
+        if (bypass)
+        {
+            if (state == State::WarmingUp)
+                state = State::Bypassed;
+            else if (state != State::Bypassed)
+                state = State::FadingOut;
+            return false;
+        }
+
+        if (state == State::Bypassed)
+        {
+            state = State::WarmingUp;
+            counter = INPUT_FILTERS_BYPASS_WARMUP;
+            return true;
+        }
+        if (state == State::FadingOut)
+            state = State::FadingIn;         // Filter never stopped: fade back from where we are
+        return false;
+    }
+
+    // Advances by one block and sets up its crossfade: the wet gain of sample n is
+    // blockWet() + (n + 1) * blockStep()
+    void advance(int32_t blockSize)
+    {
+        const float fadeInc = 1.0f / (float)INPUT_FILTERS_BYPASS_FADE;
+        startWet = wet;
+
+        switch (state)
+        {
+            case State::WarmingUp:
+                counter -= blockSize;
+                if (counter <= 0)
+                    state = State::FadingIn;
+                break;
+            case State::FadingIn:
+                wet = std::fmin(wet + fadeInc * (float)blockSize, 1.0f);
+                if (wet >= 1.0f)
+                    state = State::Active;
+                break;
+            case State::FadingOut:
+                wet = std::fmax(wet - fadeInc * (float)blockSize, 0.0f);
+                if (wet <= 0.0f)
+                    state = State::Bypassed;
+                break;
+            default:
+                break;
+        }
+
+        stepPerSample = (wet - startWet) / (float)blockSize;
+        // A fade-out that ends inside this block still needs the filter for this block
+        running = (state != State::Bypassed) || startWet > 0.0f;
+    }
+
+    bool isRunning() const { return running; }
+    bool isFading() const { return stepPerSample != 0.0f; }
+    float blockWet() const { return startWet; }
+    float blockStep() const { return stepPerSample; }
+
+private:
+    State state = State::Active;
+    int32_t counter = 0;
+    float wet = 1.0f;
+    float startWet = 1.0f;
+    float stepPerSample = 0.0f;
+    bool running = true;
+};
+
 class InputFilters
 {
 public:
@@ -29,20 +134,39 @@ public:
 
     void processBlock(float* bufferL, float* bufferR, int32_t blockSize);
     void processBlockMakeup(float* bufferL, float* bufferR, int32_t blockSize);
+    // False when processBlock() / processBlockMakeup() leave the audio untouched
+    bool isActive() const { return onOff; }
+    bool isMakeupActive() const { return onOff && makeup; }
+    // Crossfades to the new delay while the makeup path is heard, jumps otherwise
     void setMakeupDelay(float delaySamples);
 
-    // Called from main thread: stage new parameters
+    // Called from main thread: stage new parameters (filter coefficients are computed here)
     void prepareParams(float lowCut, float highCut, bool enabled, bool makeupEnabled);
-    // Called from interrupt: apply staged parameters
-    void applyParams();
+    // Called from main thread: posts a staged update the interrupt hasn't taken yet
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
 
 private:
-    // Staged values — written from main, consumed by applyParams() in interrupt
-    float pendingLowCut;
-    float pendingHighCut;
-    bool pendingOnOff;
-    bool pendingMakeup;
-    volatile bool paramsDirty;
+    // Everything the interrupt needs for a parameter change, precomputed on the main thread
+    struct StagedParams
+    {
+        bool onOff;
+        bool makeup;
+        float lowCutFreq, highCutFreq;
+        bool lowBypass, highBypass;
+        float lowG, lowH;
+        float highG, highH;
+    };
+
+    // Requested values — main thread only
+    float reqLowCut;
+    float reqHighCut;
+    bool reqOnOff;
+    bool reqMakeup;
+    bool requestDirty;
+
+    CoefMailbox<StagedParams> mailbox;
 
     // Volatile to avoid register caching during compiling optimization 
     volatile bool onOff;
@@ -51,12 +175,22 @@ private:
     int numChannels;
     float lowCutFreq;
     float highCutFreq;
+    float lowBypassHz;      // Bypass at or below / at or above these cutoffs (prepare())
+    float highBypassHz;
+
+    // Stereo instances (lane 0 = L, lane 1 = R)
+    LinkwitzRileyFilter<float> lowCutFilter;
+    LinkwitzRileyFilter<float> highCutFilter;
+
+    FilterAutoBypass lowBypass;
+    FilterAutoBypass highBypass;
 
-    LinkwitzRileyFilter<float> lowCutFilter[2];
-    LinkwitzRileyFilter<float> highCutFilter[2];
+    template <bool LowRun, bool HighRun>
+    void processStereo(float* bufferL, float* bufferR, int32_t blockSize);
 
     // Change objects to pointers
     MakeupDelayLine* makeupDelay[2];
+    LatencyTap makeupTap;
 
     // Use a safe max size for internarl scratch buffers
     float makeupLowBuffer[2][SAFE_MAX_BLOCK_SIZE];
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef DAISY_LATENCYTAP_H
+#define DAISY_LATENCYTAP_H
+
+// Crossfade length when the compensated latency changes (~10 ms at 48 kHz). Stages that
+// switch their own delay in or out (wow/flutter) fade over the same length, so the wet
+// and compensation paths move together
+#define LATENCY_FADE_SAMPLES 480
+
+/**
+ * @brief Read position of a latency compensation line (dry or makeup path).
+ * A new delay doesn't jump the tap, which would splice two unrelated points of the
+ * signal: the old and the new tap are read together and crossfaded over
+ * LATENCY_FADE_SAMPLES. A change arriving during a fade waits for it to end.
+ * Interrupt only; one instance serves both channels of a line pair.
+ */
+class LatencyTap
+{
+public:
+    /** Jump to `delay` without a fade (cleared lines, or lines nobody hears). */
+    void reset(float delay)
+    {
+        current = previous = target = delay;
+        fadeLeft = 0;
+    }
+
+    void setTarget(float delay) { target = delay; }
+
+    bool isFading() const { return fadeLeft > 0; }
+
+    /** Once per sample, before the reads. */
+    inline void tick()
+    {
+        if (fadeLeft > 0)
+        {
+            --fadeLeft;
+        }
+        else if (target != current)
+        {
+            previous = current;
+            current  = target;
+            fadeLeft = LATENCY_FADE_SAMPLES;
+        }
+    }
+
+    template <typename Line>
+    inline float read(const Line& line) const
+    {
+        const float now = line.Read(current);
+        if (fadeLeft == 0)
+            return now;
+        const float g = (float)fadeLeft * (1.0f / LATENCY_FADE_SAMPLES);
+        return now + g * (line.Read(previous) - now);
+    }
+
+private:
+    float current = 0.0f;   // Delay being faded to (read alone once the fade ends)
+    float previous = 0.0f;  // Delay being faded from
+    float target = 0.0f;    // Latest requested delay
+    int fadeLeft = 0;
+};
+
+#endif // DAISY_LATENCYTAP_H
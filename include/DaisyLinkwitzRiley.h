@@ -2,11 +2,20 @@
 #ifndef DAISY_LINKWITZRILEYFILTER_H
 #define DAISY_LINKWITZRILEYFILTER_H
 
+#include "Config.h"
+#include "DaisyFastMath.h"
+#include "DaisyDenormals.h"
 #include <cmath>
 #include <array>
 #include <algorithm>
 #include <cassert>
 
+#if DAISYTAPE_FASTMATH_FILTERS
+using LinkwitzRileyMath = FastMath;
+#else
+using LinkwitzRileyMath = StdMath;
+#endif
+
 /** 4th-order Linkwitz-Riley Filter (2-channel version)
  * Ported from the JUCE implementation, adapted for Daisy Seed.
  */
@@ -19,6 +28,10 @@ public:
         : numChannels_(0),
           g_(static_cast<SampleType>(0)),
           h_(static_cast<SampleType>(0)),
+          gTarget_(static_cast<SampleType>(0)),
+          hTarget_(static_cast<SampleType>(0)),
+          gStep_(static_cast<SampleType>(0)),
+          glideRemaining_(0),
           sampleRate_(48000.0),
           cutoffFrequency_(static_cast<SampleType>(2000.0))
     {
@@ -36,6 +49,67 @@ public:
         update();
     }
 
+    /** Computes the coefficients for a cutoff without touching any filter state.
+     *  Safe to call from the main thread; pair with setCoefs() in the interrupt. */
+    static void calcCoefs(SampleType cutoffHz, double sampleRate, SampleType& g, SampleType& h)
+    {
+        // Prewarp in SampleType, the precision g is stored in (FastMath is float only)
+        g = LinkwitzRileyMath::tan(static_cast<SampleType>(M_PI * cutoffHz / sampleRate));
+        h = static_cast<SampleType>(1.0 / (1.0 + R2_ * g + g * g));
+    }
+
+    /** Installs coefficients computed by calcCoefs() (copy only, no maths). */
+    void setCoefs(SampleType cutoffHz, SampleType g, SampleType h) noexcept
+    {
+        cutoffFrequency_ = cutoffHz;
+        g_ = g;
+        h_ = h;
+        glideRemaining_ = 0;
+    }
+
+    /** Glides to coefficients computed by calcCoefs() over numSamples calls to tick().
+     *  g moves linearly (no tan per sample); h follows with one Newton-Raphson step
+     *  of 1 / (1 + R2 g + g^2) per sample, seeded by the previous h. The glide lands
+     *  exactly on (g, h). A new glide starts from wherever the current one is. */
+    void glideTo(SampleType cutoffHz, SampleType g, SampleType h, int numSamples) noexcept
+    {
+        // Re-posting the current target is common (control loop), don't restart the glide
+        if (g == (glideRemaining_ > 0 ? gTarget_ : g_))
+            return;
+
+        cutoffFrequency_ = cutoffHz;
+        if (numSamples <= 1)
+        {
+            setCoefs(cutoffHz, g, h);
+            return;
+        }
+        gTarget_ = g;
+        hTarget_ = h;
+        gStep_ = (g - g_) / static_cast<SampleType>(numSamples);
+        glideRemaining_ = numSamples;
+    }
+
+    /** Advances a running glide by one sample. Call once per sample, before processSample()
+     *  for all channels; a single compare when idle. */
+    inline void tick() noexcept
+    {
+        if (glideRemaining_ <= 0)
+            return;
+
+        if (--glideRemaining_ == 0)
+        {
+            g_ = gTarget_;
+            h_ = hTarget_;
+            return;
+        }
+
+        g_ += gStep_;
+        const SampleType d = static_cast<SampleType>(1) + (R2_ + g_) * g_;
+        h_ = h_ * (static_cast<SampleType>(2) - d * h_);
+    }
+
+    bool isGliding() const noexcept { return glideRemaining_ > 0; }
+
     /** Initializes the filter. */
     void prepare(double newSampleRate, int newNumChannels)
     {
@@ -52,50 +126,90 @@ public:
     /** Resets the internal state variables of the filter. */
     void reset()
     {
-        for (int ch = 0; ch < numChannels_; ++ch)
-            std::fill(state_[ch].begin(), state_[ch].end(), static_cast<SampleType>(0));
+        for (auto& lanes : state_)
+            lanes.fill(static_cast<SampleType>(0));
     }
 
     /** Processes one sample, returning low-pass and high-pass outputs. */
     inline void processSample(size_t ch, SampleType x, SampleType& outputLow, SampleType& outputHigh) noexcept
     {
         // assumes ch < numChannels (validated by caller)
-        auto yH = (x - (R2_ + g_) * state_[ch][0] - state_[ch][1]) * h_;
+        auto yH = (x - (R2_ + g_) * state_[0][ch] - state_[1][ch]) * h_;
 
         auto tB = g_ * yH;
-        auto yB = tB + state_[ch][0];
-        state_[ch][0] = tB + yB;
+        auto yB = tB + state_[0][ch];
+        state_[0][ch] = tB + yB;
 
         auto tL = g_ * yB;
-        auto yL = tL + state_[ch][1];
-        state_[ch][1] = tL + yL;
+        auto yL = tL + state_[1][ch];
+        state_[1][ch] = tL + yL;
 
-        auto yH2 = (yL - (R2_ + g_) * state_[ch][2] - state_[ch][3]) * h_;
+        auto yH2 = (yL - (R2_ + g_) * state_[2][ch] - state_[3][ch]) * h_;
 
         auto tB2 = g_ * yH2;
-        auto yB2 = tB2 + state_[ch][2];
-        state_[ch][2] = tB2 + yB2;
+        auto yB2 = tB2 + state_[2][ch];
+        state_[2][ch] = tB2 + yB2;
 
         auto tL2 = g_ * yB2;
-        auto yL2 = tL2 + state_[ch][3];
-        state_[ch][3] = tL2 + yL2;
+        auto yL2 = tL2 + state_[3][ch];
+        state_[3][ch] = tL2 + yL2;
 
         outputLow  = yL2;
         outputHigh = yL - R2_ * yB + yH - yL2;
     }
 
-    /** Manually clears denormals (values near zero). */
+    /** Processes one stereo sample (needs 2 channels): both lanes step together through
+     *  the same arithmetic as processSample(), so L and R are two independent dependency
+     *  chains the FPU can interleave (or a SIMD target can pack). */
+    inline void processSampleStereo(const SampleType (&x)[2], SampleType (&outputLow)[2],
+                                    SampleType (&outputHigh)[2]) noexcept
+    {
+        const SampleType k = R2_ + g_;
+        SampleType yH[2], yB[2], yL[2], yH2[2], yB2[2], yL2[2];
+
+        for (int c = 0; c < 2; ++c)
+        {
+            yH[c] = (x[c] - k * state_[0][c] - state_[1][c]) * h_;
+            const SampleType tB = g_ * yH[c];
+            yB[c] = tB + state_[0][c];
+            state_[0][c] = tB + yB[c];
+        }
+        for (int c = 0; c < 2; ++c)
+        {
+            const SampleType tL = g_ * yB[c];
+            yL[c] = tL + state_[1][c];
+            state_[1][c] = tL + yL[c];
+        }
+        for (int c = 0; c < 2; ++c)
+        {
+            yH2[c] = (yL[c] - k * state_[2][c] - state_[3][c]) * h_;
+            const SampleType tB2 = g_ * yH2[c];
+            yB2[c] = tB2 + state_[2][c];
+            state_[2][c] = tB2 + yB2[c];
+        }
+        for (int c = 0; c < 2; ++c)
+        {
+            const SampleType tL2 = g_ * yB2[c];
+            yL2[c] = tL2 + state_[3][c];
+            state_[3][c] = tL2 + yL2[c];
+
+            outputLow[c]  = yL2[c];
+            outputHigh[c] = yL[c] - R2_ * yB[c] + yH[c] - yL2[c];
+        }
+    }
+
+    /** Manually clears denormals (values near zero). Per state: a state holding DC
+     *  (low cut fed an offset) must not keep the decayed ones from being cleared. */
     inline void snapToZero() noexcept
     {
-        // Hardcoded threshold
-        const SampleType zeroThreshold = static_cast<SampleType>(1.0e-9);       // TODO: test which value works best
+        const SampleType zeroThreshold = static_cast<SampleType>(DENORMAL_SNAP_THRESHOLD);
 
-        for (int ch = 0; ch < numChannels_; ++ch)
+        for (auto& lanes : state_)
         {
-            for (auto& element : state_[ch])
+            for (int ch = 0; ch < numChannels_; ++ch)
             {
-                if (std::fabs(element) < zeroThreshold)
-                    element = static_cast<SampleType>(0);
+                if (std::fabs(lanes[ch]) < zeroThreshold)
+                    lanes[ch] = static_cast<SampleType>(0);
             }
         }
     }
@@ -103,17 +217,73 @@ public:
 private:
     void update()
     {
-        g_ = static_cast<SampleType>(std::tan(M_PI * cutoffFrequency_ / sampleRate_));
-        h_ = static_cast<SampleType>(1.0 / (1.0 + R2_ * g_ + g_ * g_));
+        calcCoefs(cutoffFrequency_, sampleRate_, g_, h_);
+        glideRemaining_ = 0;
     }
 
     int numChannels_;
     SampleType g_, h_;
     static constexpr SampleType R2_ = static_cast<SampleType>(1.41421356237);
-    std::array<std::array<SampleType, 4>, 2> state_; // 2 channels max
+    std::array<std::array<SampleType, 2>, 4> state_; // [state][channel], 2 channels max
+
+    // Cutoff glide (see glideTo())
+    SampleType gTarget_, hTarget_, gStep_;
+    int glideRemaining_;
 
     double sampleRate_;
     SampleType cutoffFrequency_;
 };
 
+/** 2nd-order allpass matching a 4th-order Linkwitz-Riley crossover at the same cutoff
+ * (low + high of the LR4 sum to exactly this). Used to phase-align bands that didn't
+ * go through a given crossover. Same TPT state-variable core and coefficients
+ * (g, h from LinkwitzRileyFilter::calcCoefs()), stereo only: half the cost of an LR4.
+ */
+template <typename SampleType>
+class LinkwitzRileyAllpass
+{
+public:
+    LinkwitzRileyAllpass()
+        : g_(static_cast<SampleType>(0)), h_(static_cast<SampleType>(1))
+    {
+        reset();
+    }
+
+    void setCoefs(SampleType g, SampleType h) noexcept
+    {
+        g_ = g;
+        h_ = h;
+    }
+
+    void reset()
+    {
+        for (auto& lanes : state_)
+            lanes.fill(static_cast<SampleType>(0));
+    }
+
+    /** In-place stereo allpass: x - 2 R2 yB of the state-variable filter. */
+    inline void processSampleStereo(SampleType (&x)[2]) noexcept
+    {
+        const SampleType k = R2_ + g_;
+        for (int c = 0; c < 2; ++c)
+        {
+            const SampleType yH = (x[c] - k * state_[0][c] - state_[1][c]) * h_;
+            const SampleType tB = g_ * yH;
+            const SampleType yB = tB + state_[0][c];
+            state_[0][c] = tB + yB;
+
+            const SampleType tL = g_ * yB;
+            const SampleType yL = tL + state_[1][c];
+            state_[1][c] = tL + yL;
+
+            x[c] = x[c] - static_cast<SampleType>(2) * R2_ * yB;
+        }
+    }
+
+private:
+    SampleType g_, h_;
+    static constexpr SampleType R2_ = static_cast<SampleType>(1.41421356237);
+    std::array<std::array<SampleType, 2>, 2> state_; // [state][channel]
+};
+
 #endif // DAISY_LINKWITZRILEYFILTER_H
\ No newline at end of file
@@ -18,6 +18,56 @@
 // Crossfade length in samples
 #define LOSS_FADE_LEN 1024
 
+// IIR approximation: biquads in the cascade (two first-order shelves each, corners
+// start an octave apart from LOSS_IIR_LOWEST_SHELF_HZ when the response is nearly
+// flat), fit iterations, fit grid and error grid sizes (log spaced, 20 Hz .. 20 kHz),
+// the level below which the response isn't fit and the one down to which it is fit
+// with full weight (and reported separately)
+#define LOSS_IIR_SECTIONS 4
+#define LOSS_IIR_LOWEST_SHELF_HZ 125.0f
+#define LOSS_IIR_FIT_POINTS 32
+#define LOSS_IIR_FIT_ITERATIONS 12
+#define LOSS_IIR_ERROR_POINTS 128
+#define LOSS_IIR_FLOOR_DB -60.0f
+#define LOSS_IIR_PASSBAND_DB -20.0f
+// Fit parameters: overall gain, then each shelf's gain (dB) and corner (log2 Hz)
+#define LOSS_IIR_PARAMS (4 * LOSS_IIR_SECTIONS + 1)
+
+// IIR fits precomputed over the firmware's knob space: tape speed log spaced over
+// LOSS_TABLE_MIN_IPS .. LOSS_TABLE_MAX_IPS, loss knob (LossFilter::lossKnob()) squared
+// over 0..1 (the shapes change fastest at low loss). A setting interpolates its cell
+// and refines that for LOSS_TABLE_REFINE_ITERATIONS; with LOSS_TABLE_REFIT_DB more
+// passband error than the cell's worst entry it is fit from scratch
+#define LOSS_TABLE_SPEEDS 13
+#define LOSS_TABLE_LOSSES 11
+#define LOSS_TABLE_MIN_IPS 1.0f
+#define LOSS_TABLE_MAX_IPS 50.0f
+#define LOSS_TABLE_REFINE_ITERATIONS 3
+#define LOSS_TABLE_REFIT_DB 0.25f
+
+/**
+ * @brief Loss filter implementation.
+ * - FIR: linear phase LOSS_FIR_ORDER-tap filter sampled from the loss response,
+ *   LOSS_FIR_ORDER / 2 samples of latency.
+ * - IIR: LOSS_IIR_SECTIONS biquads fit to the same response's magnitude each time
+ *   the parameters change. Minimum phase, no latency, about a quarter of the FIR's
+ *   multiplies. For dense sessions and live use; getIirFitError() tells how close
+ *   it is to the FIR for the current setting.
+ * - IIRAligned: the same IIR fit behind a LOSS_FIR_ORDER / 2 sample delay (read from
+ *   the FIR's input history), so the latency matches the FIR's and a switch between
+ *   the two doesn't move the dry and makeup paths. What the CPU governor falls back to.
+ * The latency is fixed by LossFilter::prepare(): a switch between the zero-latency IIR
+ * and the others while running would crossfade two signals LOSS_FIR_ORDER / 2 samples
+ * apart (comb filtering) and then move the dry and makeup paths.
+ */
+enum class LossFilterMode : int
+{
+    FIR = 0,
+    IIR,
+    IIRAligned,
+    NumModes
+};
+
 /**
  * @brief A simple Stereo FIR Filter with settable coefficients.
  */
@@ -29,6 +79,12 @@ public:
     void reset() {
         for(int i=0; i<LOSS_FIR_ORDER; i++) {
             coeffs[i] = 0.0f;
+        }
+        clearState();
+    }
+
+    void clearState() {
+        for(int i=0; i<LOSS_FIR_ORDER; i++) {
             stateL[i] = 0.0f;
             stateR[i] = 0.0f;
         }
@@ -75,6 +131,21 @@ public:
         if(head >= LOSS_FIR_ORDER) head = 0;
     }
 
+    // Input history only, no convolution: returns the input delaySamples ago
+    // (< LOSS_FIR_ORDER). The history stays valid for process()
+    inline void delay(float inL, float inR, int delaySamples, float& outL, float& outR) {
+        stateL[head] = inL;
+        stateR[head] = inR;
+
+        int idx = head - delaySamples;
+        if(idx < 0) idx += LOSS_FIR_ORDER;
+        outL = stateL[idx];
+        outR = stateR[idx];
+
+        head++;
+        if(head >= LOSS_FIR_ORDER) head = 0;
+    }
+
 private:
     float coeffs[LOSS_FIR_ORDER];
     float stateL[LOSS_FIR_ORDER];
@@ -91,9 +162,13 @@ struct StereoBiquad {
     float xR[2], yR[2];
 
     void reset() {
+        clearState();
+        b0=b1=b2=a1=a2=0.0f;
+    }
+
+    void clearState() {
         xL[0]=xL[1]=yL[0]=yL[1]=0.0f;
         xR[0]=xR[1]=yR[0]=yR[1]=0.0f;
-        b0=b1=b2=a1=a2=0.0f;
     }
 
     void copyStateFrom(const StereoBiquad& other) {
@@ -121,47 +196,188 @@ struct StereoBiquad {
     }
 };
 
+/**
+ * @brief LOSS_IIR_SECTIONS stereo biquads in series (the loss filter's IIR mode).
+ */
+struct StereoBiquadCascade {
+    StereoBiquad sections[LOSS_IIR_SECTIONS];
+
+    void reset() {
+        for (StereoBiquad& s : sections) s.reset();
+    }
+
+    void clearState() {
+        for (StereoBiquad& s : sections) s.clearState();
+    }
+
+    void copyStateFrom(const StereoBiquadCascade& other) {
+        for (int i = 0; i < LOSS_IIR_SECTIONS; i++) sections[i].copyStateFrom(other.sections[i]);
+    }
+
+    // b0, b1, b2, a1, a2 per section
+    void setCoefficients(const float* c) {
+        for (int i = 0; i < LOSS_IIR_SECTIONS; i++, c += 5)
+            sections[i].setCoeffs(c[0], c[1], c[2], c[3], c[4]);
+    }
+
+    inline void process(float inL, float inR, float& outL, float& outR) {
+        outL = inL;
+        outR = inR;
+        for (int i = 0; i < LOSS_IIR_SECTIONS; i++)
+            sections[i].process(outL, outR, outL, outR);
+    }
+};
+
+/**
+ * @brief IIR fit parameters on the LOSS_TABLE_SPEEDS x LOSS_TABLE_LOSSES knob grid, for
+ * one sample rate. Filled by LossFilter::runWorker() one entry per call after
+ * prepare(); 10 kB, main thread only, so it doesn't belong in the TCM.
+ */
+struct LossIirTable
+{
+    float fs = 0.0f;
+    int filled = 0;     // Entries done, in order
+    float params[LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES][LOSS_IIR_PARAMS];
+    float passbandDb[LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES];   // Fit error above LOSS_IIR_PASSBAND_DB
+};
+
 class LossFilter
 {
 public:
     LossFilter();
     ~LossFilter() {}
 
-    void prepare(float sampleRate);
+    /**
+     * @brief Starts in `mode`, which also fixes the latency until the next prepare():
+     * started in FIR or IIRAligned, IIR requests run as IIRAligned; started in IIR,
+     * every request runs as IIR.
+     */
+    void prepare(float sampleRate, LossFilterMode mode = LossFilterMode::FIR);
+
+    /**
+     * @brief Main thread, before prepare(): table of IIR fits over the knob space.
+     * IIR requests on the knob curve (lossKnob()) then start from it and only refine,
+     * about a third of a full fit (~1.5 ms on the host); others, and all of them until
+     * the table is full, still fit from scratch. nullptr: always fit.
+     */
+    void setIirTable(LossIirTable* table) { iirTable = table; }
+
+    /** Head geometry for a loss knob position (0..1): spacing, thickness and gap in microns. */
+    static void lossKnob(float loss, float& spacing, float& thickness, float& gap)
+    {
+        spacing   = 0.1f + loss * 19.9f;
+        thickness = 0.1f + loss * 49.9f;
+        gap       = 1.0f + loss * 49.0f;
+    }
 
     // Called from main thread: compute coefficients into staging buffers
-    void prepareParams(float speed, float spacing, float thickness, float gap);
-    // Called from interrupt: atomically swap staged coefficients into back buffer and arm fade
-    void applyParams();
+    void prepareParams(float speed, float spacing, float thickness, float gap,
+                       LossFilterMode mode = LossFilterMode::FIR);
+    // Called from main thread: stages a request prepareParams() couldn't (crossfade running),
+    // otherwise fits the next IIR table entry
+    void runWorker();
+    // Called from interrupt: atomically swap staged coefficients into back buffer and arm fade.
+    // True when a new set was installed
+    bool applyParams();
 
     // Called from interrupt: apply filter and handle crossfade
     void processBlock(float* inL, float* inR, float* outL, float* outR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return onOff; }
 
     float getLatencySamples() const;
 
+    /**
+     * @brief Main thread: magnitude error of the IIR fit against the FIR for the last
+     * IIR setting staged, in dB over 20 Hz .. 20 kHz (levels below LOSS_IIR_FLOOR_DB
+     * count as the floor): max and RMS, and max where the FIR is above
+     * LOSS_IIR_PASSBAND_DB. All 0 until an IIR setting has been staged.
+     */
+    void getIirFitError(float& maxDb, float& rmsDb, float& passbandMaxDb) const
+    {
+        maxDb = iirMaxErrorDb;
+        rmsDb = iirRmsErrorDb;
+        passbandMaxDb = iirPassbandErrorDb;
+    }
+
+    /**
+     * @brief Per-sample form for fused chains (DaisyStageChain.h). beginBlock() starts a
+     * pending crossfade and returns true when processSample() applies to this block
+     * (filter on, no crossfade running).
+     */
+    bool beginBlock();
+    inline void processSample(float& l, float& r)
+    {
+        float lossL, lossR;
+        processLoss(fusedIdx, l, r, lossL, lossR);
+        bumpFilters[fusedIdx].process(lossL, lossR, l, r);
+    }
+
 private:
+    // One sample through slot idx's FIR, IIR cascade, or delay and IIR cascade (no bump)
+    inline void processLoss(int idx, float l, float r, float& outL, float& outR)
+    {
+        switch (slotMode[idx])
+        {
+            case LossFilterMode::IIR:
+                iirFilters[idx].process(l, r, outL, outR);
+                break;
+            case LossFilterMode::IIRAligned:
+                firFilters[idx].delay(l, r, LOSS_FIR_ORDER / 2, l, r);
+                iirFilters[idx].process(l, r, outL, outR);
+                break;
+            case LossFilterMode::FIR:
+            default:
+                firFilters[idx].process(l, r, outL, outR);
+                break;
+        }
+    }
+
     // Math helpers
+    void startFade();
     void calcHeadBumpCoeffs(float speedIps, float gapMeters, StereoBiquad& filter);
     void calcFirCoeffs(float speed, float spacing, float thickness, float gap);
+    // Fit to the FIR in computedFir[], from the staircase or (warmStart) from x
+    void fitIir(double* x, int iterations = LOSS_IIR_FIT_ITERATIONS, bool warmStart = false);
+    void setIirCoeffs(const double* x);
+    void designIir();   // computedIir[] from the table or a fit, with its error
+    bool lookupIirTable(double* x, float& cellPassbandDb) const;
+    void fillIirTable();
+    double firAmplitude(double cosW) const;
+    void measureIirError(float& maxDb, float& rmsDb, float& passbandDb) const;
+    void stage();
 
     float fs;
     bool onOff;
+    bool zeroLatency;   // Started in IIR (prepare())
+    LossIirTable* iirTable;
 
-    // Double-buffered filters (active and inactive/fading)
+    // Double-buffered filters (active and inactive/fading). Each slot runs its FIR or
+    // its IIR cascade, then its bump filter
     StereoFIR firFilters[2];
+    StereoBiquadCascade iirFilters[2];
     StereoBiquad bumpFilters[2];
+    LossFilterMode slotMode[2];
 
     volatile int activeFilterIdx;
+    int fusedIdx;   // activeFilterIdx as of beginBlock(), interrupt only
     volatile int fadeCounter;
     volatile bool triggerFade;
 
     // Staging — written from main (prepareParams), read from interrupt (applyParams)
     volatile bool stageReady;
     float computedFir[LOSS_FIR_ORDER]; // staged FIR coefficients
+    float computedIir[LOSS_IIR_SECTIONS * 5];  // staged IIR coefficients (IIR mode)
     StereoBiquad stagedBump;           // staged bump filter coefficients
+    LossFilterMode stagedMode;
 
     // Parameters — stored to suppress redundant recomputes
     float p_speed, p_spacing, p_thickness, p_gap;
+    LossFilterMode p_mode;
+    bool requestDirty;      // p_* not staged yet (main thread only)
+
+    // Fit error of the last IIR set staged (main thread only)
+    float iirMaxErrorDb, iirRmsErrorDb, iirPassbandErrorDb;
 
     // Temporary frequency-domain buffer used during FIR calculation
     float Hcoefs[LOSS_FIR_ORDER];
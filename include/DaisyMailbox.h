@@ -0,0 +1,49 @@
+#pragma once
+#ifndef DAISY_MAILBOX_H
+#define DAISY_MAILBOX_H
+
+#include "daisy_seed.h"
+
+/**
+ * @brief One-slot, single-producer / single-consumer coefficient mailbox.
+ * The producer is the main loop (control worker), the consumer the audio interrupt.
+ * Both sides are wait-free: post() only writes into an empty slot and fetch() only
+ * copies out of a full one, so the interrupt can never see a half-written set.
+ * If the slot is still full, post() fails and the producer retries on its next tick.
+ */
+template <typename T>
+class CoefMailbox
+{
+public:
+    /** Main thread: true if post() would succeed. */
+    bool canPost() const { return !full; }
+
+    /** Main thread: hand a complete coefficient set over to the interrupt. */
+    bool post(const T& value)
+    {
+        if (full) return false;
+        data = value;
+        __DMB();    // all stores of the set must land before the flag
+        full = true;
+        return true;
+    }
+
+    /** Interrupt: the pending set without taking it, nullptr if none. */
+    const T* peek() const { return full ? &data : nullptr; }
+
+    /** Interrupt: copy out the pending set, if any. */
+    bool fetch(T& out)
+    {
+        if (!full) return false;
+        out = data;
+        __DMB();
+        full = false;
+        return true;
+    }
+
+private:
+    T data;
+    volatile bool full = false;
+};
+
+#endif // DAISY_MAILBOX_H
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef DAISY_MEMORY_H
+#define DAISY_MEMORY_H
+
+#include "Config.h"
+
+/**
+ * @brief Tightly coupled memory placement for the audio path.
+ * With APP_TYPE = BOOT_SRAM the program runs from AXI SRAM, which goes through the
+ * M7 caches and competes with DMA. The TCMs are zero wait state and bypass both:
+ * - DAISYTAPE_DTCM: audio-rate state (the TapeProcessor instance with all module
+ *   filter states, FIR coefficients and scratch buffers) -> DTCMRAM (128 kB).
+ *   libDaisy's .dtcmram_bss section is NOLOAD and not zeroed at startup: objects
+ *   placed there must set up their state in constructors / prepare().
+ *   The main stack grows down from the top of the same 128 kB, so the state is held
+ *   to DAISYTAPE_DTCM_BUDGET (static_assert next to the instance in DaisyTape.cpp).
+ * - DAISYTAPE_ITCM: processBlock() functions -> ITCMRAM (64 kB), copied there from
+ *   the load image at startup. GCC ignores section attributes on template
+ *   instantiations, so templated kernels that aren't inlined anyway (the stage
+ *   chains, the hysteresis solvers) stay in AXI SRAM with the rest of the program.
+ * tools/footprint.py (make footprint) shows what ended up where.
+ * Host builds, and DAISYTAPE_TCM_PLACEMENT = 0, leave placement to the linker.
+ */
+#if DAISYTAPE_TCM_PLACEMENT && defined(__arm__)
+#define DAISYTAPE_DTCM __attribute__((section(".dtcmram_bss")))
+#define DAISYTAPE_ITCM __attribute__((section(".itcmram")))
+#else
+#define DAISYTAPE_DTCM
+#define DAISYTAPE_ITCM
+#endif
+
+#endif // DAISY_MEMORY_H
@@ -0,0 +1,238 @@
+#pragma once
+#ifndef DAISY_RANDOMEVENTS_H
+#define DAISY_RANDOMEVENTS_H
+
+#include "daisy_seed.h"
+#include "DaisyMailbox.h"
+#include "DaisyDegrade.h"   // JuceRandom
+#include "DaisyTelemetry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Timing of a RandomEvents sequence: mean gap between events at freq 0 and 1
+ * (log interpolated), ramp in and out of an event (also the shortest gap or event),
+ * and the wait before asking again when the worker hasn't delivered the next event.
+ */
+struct RandomEventTiming
+{
+    float maxGapS;
+    float minGapS;
+    float rampMs;
+    int32_t holdSamples;
+};
+
+/**
+ * @brief Scheduling shared by the random event stages (ChewProcessor, DropoutProcessor):
+ * a sequence of events, each a clean gap followed by the event proper, drawn from
+ * JuceRandom by the main thread worker and handed over one at a time through a
+ * mailbox, the way DegradeProcessor cooks its parameters. The interrupt only takes
+ * the next event when the current one runs out, and drops the pending one when the
+ * parameters change.
+ * Event is the stage's own struct with int32_t gap and length (0: gap only) plus
+ * whatever its DSP needs; the stage draws those fields, this class the timing.
+ * The stage's processBlock() walks the block with advance() and reacts to the edges.
+ */
+template <typename Event>
+class RandomEvents
+{
+public:
+    // What starts with the run advance() returns
+    enum class Edge : uint8_t
+    {
+        None,   // Same phase as the previous run
+        Start,  // Gap over: the event in current() starts
+        End,    // Event over (or nothing to wait for): back to clean
+    };
+
+    RandomEvents(const RandomEventTiming& t, uint64_t seed)
+        : timing(t), fs(48000.0f), rampSamples(0),
+          onOff(false), fadingOut(false), inGap(false), samplesLeft(0),
+          req_depth(0.0f), req_freq(0.0f), req_variance(0.0f),
+          req_onOff(false), liveDirty(false)
+    {
+        rng.setSeed(seed);
+        next = Event{};
+    }
+
+    /** Main thread: event lengths depend on fs, drops anything drawn before and restarts clean. */
+    void prepare(float sampleRate)
+    {
+        fs = sampleRate;
+        rampSamples = (int32_t)(timing.rampMs * 0.001f * fs);
+
+        Event stale;
+        eventBox.fetch(stale);
+        next = Event{};
+        fadingOut = false;
+        inGap = false;
+        samplesLeft = 0;
+    }
+
+    /** Main thread: stage new parameters (all 0..1). */
+    void prepareParams(float depth, float freq, float variance, bool enabled)
+    {
+        req_depth    = std::fmin(std::fmax(depth, 0.0f), 1.0f);
+        req_freq     = std::fmin(std::fmax(freq, 0.0f), 1.0f);
+        req_variance = std::fmin(std::fmax(variance, 0.0f), 1.0f);
+        req_onOff    = enabled;
+        liveDirty    = true;
+    }
+
+    /**
+     * Main thread (control rate): retries the flags, keeps the next event drawn.
+     * drawEvent(Event&) fills length and the stage's fields once the gap is drawn;
+     * it isn't called at depth 0 (gaps only).
+     */
+    template <typename Draw>
+    void runWorker(Draw drawEvent)
+    {
+        if (liveDirty && liveBox.post(req_onOff))
+            liveDirty = false;
+
+        // Keep the next event ready: the interrupt takes one when the current one ends
+        if (!eventBox.canPost())
+            return;
+        Event e{};
+        e.gap = (int32_t)std::fmax(vary(timing.maxGapS * std::pow(timing.minGapS / timing.maxGapS, req_freq)) * fs,
+                                   (float)rampSamples);
+        e.length = 0;
+        if (req_depth > 0.0f)
+            drawEvent(e);
+        eventBox.post(e);
+    }
+
+    /**
+     * Interrupt: takes a staged on/off flag, true when one was installed.
+     * switchedOn: the stage was off, it restarts from clean and takes a fresh event.
+     * Switched on again while still ramping out, it carries on from where its ramp is.
+     */
+    bool applyParams(bool& switchedOn)
+    {
+        bool enabled;
+        if (!liveBox.fetch(enabled)) return false;
+        Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+
+        // The pending event was drawn with the old parameters, and so was a running gap
+        // (up to seconds long): drop the one, cut the other short. An event plays out
+        Event stale;
+        eventBox.fetch(stale);
+        if (inGap)
+        {
+            inGap = false;
+            samplesLeft = std::min(samplesLeft, rampSamples);
+        }
+
+        switchedOn = false;
+        if (enabled && !onOff)
+        {
+            switchedOn = !fadingOut && samplesLeft <= 0;
+            fadingOut = false;
+            samplesLeft = 0;
+        }
+        else if (!enabled && onOff)
+        {
+            // Switched off: an event in progress ramps back to clean before the stage
+            // goes inactive (the next advance() starts with Edge::End)
+            fadingOut = true;
+            inGap = false;
+            samplesLeft = 0;
+        }
+        onOff = enabled;
+        return true;
+    }
+
+    /** Interrupt: on, or switched off and still ramping back to clean. */
+    bool isActive() const { return onOff || fadingOut || samplesLeft > 0; }
+
+    /**
+     * Interrupt: length of the next run, at most maxSamples and within one phase, and
+     * the edge at its start. Call until the block is covered.
+     */
+    inline Edge advance(int32_t maxSamples, int32_t& run)
+    {
+        Edge edge = Edge::None;
+        if (samplesLeft <= 0)
+            edge = nextPhase(maxSamples);
+        run = std::min(maxSamples, samplesLeft);
+        samplesLeft -= run;
+        return edge;
+    }
+
+    /** Interrupt: the event an Edge::Start began. */
+    const Event& current() const { return next; }
+
+    /** Main thread, for drawEvent(): requested parameters and the generator. */
+    float depth() const { return req_depth; }
+    float variance() const { return req_variance; }
+    float nextFloat() { return rng.nextFloat(); }
+    int32_t getRampSamples() const { return rampSamples; }
+    float getSampleRate() const { return fs; }
+
+    /** Main thread: `mean` varied by +-25%, up to +-95% with full variance. */
+    float vary(float mean)
+    {
+        const float spread = 0.25f + 0.7f * req_variance;
+        return mean * (1.0f + spread * (2.0f * rng.nextFloat() - 1.0f));
+    }
+
+private:
+    Edge nextPhase(int32_t maxSamples)
+    {
+        // Switched off: one last Edge::End ramps back to clean. Once that ramp has run
+        // out, the rest of the block stays clean and isActive() turns false
+        if (!onOff)
+        {
+            const Edge edge = fadingOut ? Edge::End : Edge::None;
+            samplesLeft = fadingOut ? rampSamples : maxSamples;
+            fadingOut = false;
+            return edge;
+        }
+
+        // End of a gap: the event starts. The gap outlasts the previous ramp out, so the
+        // stage can switch its settings here
+        if (inGap && next.length > 0)
+        {
+            inGap = false;
+            samplesLeft = next.length;
+            return Edge::Start;
+        }
+
+        // End of an event (or nothing to wait for): take the next one
+        if (eventBox.fetch(next))
+        {
+            inGap = true;
+            samplesLeft = next.gap;
+        }
+        else
+        {
+            // Worker late: stay clean a little longer
+            inGap = false;
+            samplesLeft = timing.holdSamples;
+        }
+        return Edge::End;
+    }
+
+    const RandomEventTiming timing;
+    float fs;
+    int32_t rampSamples;
+
+    // Live values — written only from interrupt
+    volatile bool onOff;
+    bool fadingOut;         // Switched off, the closing Edge::End not yet returned
+    Event next;             // Event whose gap (then event) is running
+    bool inGap;             // False: in an event, or waiting for one
+    int32_t samplesLeft;
+
+    // Requested values — main thread only
+    float req_depth, req_freq, req_variance;
+    bool req_onOff;
+    bool liveDirty;
+    JuceRandom rng;         // Main thread only (drawn by the worker)
+
+    CoefMailbox<bool> liveBox;
+    CoefMailbox<Event> eventBox;
+};
+
+#endif // DAISY_RANDOMEVENTS_H
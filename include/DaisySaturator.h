@@ -0,0 +1,146 @@
+#pragma once
+#ifndef DAISY_SATURATOR_H
+#define DAISY_SATURATOR_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include "DaisyMailbox.h"
+#include "DaisyDegrade.h"   // LinSmoothed
+#include <cmath>
+#include <cstdint>
+
+// Transfer curve table: f(x) = tanh(x) and F(x) = log(cosh(x)) on [0, SAT_TABLE_MAX_X],
+// SAT_TABLE_SIZE intervals. Both are symmetric, beyond the table f = sign(x) and
+// F = |x| - ln 2 (tanh(8) is 1 - 2e-7)
+#define SAT_TABLE_SIZE 512
+#define SAT_TABLE_MAX_X 8.0f
+
+// Below this input step the ADAA quotient is replaced by f at the midpoint: the
+// difference of two F values would cancel, and the midpoint is exact to O(step^2)
+#define SAT_ADAA_EPS 1.0e-3f
+
+// Drive range (input gain in dB at drive = 1) and gain ramp on parameter changes
+#define SAT_MAX_DRIVE_DB 24.0f
+#define SAT_RAMP_MS 20.0f
+
+/**
+ * @brief Lightweight tape saturation: tanh curve with first-order antiderivative
+ * anti-aliasing (ADAA). Instead of f(x[n]) each sample outputs the mean of f over the
+ * segment from x[n-1] to x[n], (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1]), which
+ * suppresses most of the aliasing of the bare curve without oversampling.
+ * f and F come from a table (Hermite interpolation of F with slopes f, so the two
+ * stay consistent), one F lookup per sample and channel. F and its state are double:
+ * F grows to ~7.3 while the quotient needs its differences over steps down to
+ * SAT_ADAA_EPS, which in float would keep only ~3 significant digits.
+ * The averaging delays the signal by half a sample (getLatencySamples()); the dry
+ * path compensation rounds the total latency to whole samples.
+ * Cheap stand-in for the hysteresis stage when that doesn't fit the budget.
+ */
+class SaturatorProcessor
+{
+public:
+    SaturatorProcessor();
+    ~SaturatorProcessor() {}
+
+    void prepare(float sampleRate);
+
+    // Called from main thread: stage new parameters (drive 0..1)
+    void prepareParams(float drive, bool enabled);
+    // Called from main thread: posts a staged update the interrupt hasn't taken yet
+    void runWorker();
+    // Called from interrupt: apply staged parameters (copy only), true when a new set was installed
+    bool applyParams();
+
+    void processBlock(float* bufferL, float* bufferR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed)
+    bool isActive() const { return onOff; }
+
+    float getLatencySamples() const;
+
+    /** Table lookups, also used by the benchmark for the non anti-aliased reference. */
+    inline float curve(float x) const;
+    inline double antiderivative(float x) const;
+
+private:
+    struct CookedParams
+    {
+        bool onOff;
+        float inputGain;
+        float outputGain;
+    };
+
+    CookedParams cook() const;
+    void install(const CookedParams& c);
+    void buildTable();
+
+    inline float processSample(int ch, float x);
+
+    float fs;
+
+    // Live values — written only from interrupt (via applyParams)
+    volatile bool onOff;
+    LinSmoothed inputGain, outputGain;
+
+    // Requested values — main thread only
+    float req_drive;
+    bool req_onOff;
+    bool requestDirty;
+
+    CoefMailbox<CookedParams> mailbox;
+
+    // ADAA state per channel: previous (gained) input and its F
+    float x1[2];
+    double F1[2];
+
+    // Curve and antiderivative at the table nodes
+    float fTable[SAT_TABLE_SIZE + 1];
+    double FTable[SAT_TABLE_SIZE + 1];
+};
+
+inline float SaturatorProcessor::curve(float x) const
+{
+    const float ax = std::fabs(x);
+    if (ax >= SAT_TABLE_MAX_X)
+        return x > 0.0f ? 1.0f : -1.0f;
+
+    const float pos = ax * ((float)SAT_TABLE_SIZE / SAT_TABLE_MAX_X);
+    const int i = (int)pos;
+    const float t = pos - (float)i;
+    const float y = fTable[i] + t * (fTable[i + 1] - fTable[i]);
+    return x < 0.0f ? -y : y;
+}
+
+inline double SaturatorProcessor::antiderivative(float x) const
+{
+    constexpr double h = (double)SAT_TABLE_MAX_X / (double)SAT_TABLE_SIZE;
+    constexpr double ln2 = 0.69314718055994531;
+
+    const double ax = std::fabs((double)x);
+    if (ax >= (double)SAT_TABLE_MAX_X)
+        return ax - ln2;
+
+    // Cubic Hermite on F with the slopes f at the nodes
+    const double pos = ax * (1.0 / h);
+    const int i = (int)pos;
+    const double t = pos - (double)i;
+    const double p0 = FTable[i], p1 = FTable[i + 1];
+    const double m0 = (double)fTable[i] * h, m1 = (double)fTable[i + 1] * h;
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+    return (2.0 * t3 - 3.0 * t2 + 1.0) * p0 + (t3 - 2.0 * t2 + t) * m0
+         + (-2.0 * t3 + 3.0 * t2) * p1 + (t3 - t2) * m1;
+}
+
+inline float SaturatorProcessor::processSample(int ch, float x)
+{
+    const double F = antiderivative(x);
+    const float dx = x - x1[ch];
+
+    const float y = (std::fabs(dx) < SAT_ADAA_EPS) ? curve(0.5f * (x + x1[ch]))
+                                                    : (float)((F - F1[ch]) / (double)dx);
+    x1[ch] = x;
+    F1[ch] = F;
+    return y;
+}
+
+#endif // DAISY_SATURATOR_H
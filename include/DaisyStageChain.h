@@ -0,0 +1,229 @@
+#pragma once
+#ifndef DAISY_STAGECHAIN_H
+#define DAISY_STAGECHAIN_H
+
+#include "DaisyInputFilters.h"
+#include "DaisyCompression.h"
+#include "DaisyHysteresis.h"
+#include "DaisyDegrade.h"
+#include "DaisyWowFlutter.h"
+#include "DaisyLossFilter.h"
+#include "DaisyAzimuthProc.h"
+#include "DaisySaturator.h"
+#include "DaisyChew.h"
+#include "DaisyDropout.h"
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @brief Stage adaptors for StageChain: thin wrappers around a module reference.
+ * - Block stages (perSample = false) only have processBlock(l, r, n).
+ * - Per-sample stages (perSample = true) also have begin() / process(l, r).
+ *   begin() returns false when the stage can't run per sample for this block
+ *   (bypassed, crossfading, other solver); the chain then uses processBlock().
+ */
+struct InputFiltersStage
+{
+    static constexpr bool perSample = false;
+    InputFilters& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct CompressionStage
+{
+    static constexpr bool perSample = true;
+    CompressionProcessor& m;
+    bool begin() { return m.isActive(); }
+    void process(float& l, float& r) { m.processSample(l, r); }
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+template <HysteresisSolver S>
+struct HysteresisStage
+{
+    static constexpr bool perSample = true;
+    HysteresisProcessor& m;
+    bool begin() { return m.isActive() && m.getSolver() == S; }
+    void process(float& l, float& r) { m.processSample<S>(l, r); }
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct ChewStage
+{
+    static constexpr bool perSample = false;
+    ChewProcessor& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct DegradeStage
+{
+    static constexpr bool perSample = false;
+    DegradeProcessor& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct DropoutStage
+{
+    static constexpr bool perSample = false;
+    DropoutProcessor& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct WowFlutterStage
+{
+    static constexpr bool perSample = false;
+    WowFlutterProcessor& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct SaturatorStage
+{
+    static constexpr bool perSample = false;
+    SaturatorProcessor& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, n); }
+};
+
+struct LossStage
+{
+    static constexpr bool perSample = true;
+    LossFilter& m;
+    bool begin() { return m.beginBlock(); }
+    void process(float& l, float& r) { m.processSample(l, r); }
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, l, r, n); }
+};
+
+struct AzimuthStage
+{
+    static constexpr bool perSample = false;
+    AzimuthProc& m;
+    void processBlock(float* l, float* r, int n) { m.processBlock(l, r, l, r, n); }
+};
+
+namespace stagechain {
+
+// One past the last stage of the per-sample run starting at I
+template <typename Tuple, std::size_t I, std::size_t N, bool InRange = (I < N)>
+struct RunEnd
+{
+    static constexpr std::size_t value =
+        std::tuple_element<I, Tuple>::type::perSample ? RunEnd<Tuple, I + 1, N>::value : I;
+};
+
+template <typename Tuple, std::size_t I, std::size_t N>
+struct RunEnd<Tuple, I, N, false>
+{
+    static constexpr std::size_t value = I;
+};
+
+// Stages [I, J) of a run, in order
+template <typename Tuple, std::size_t I, std::size_t J>
+struct Run
+{
+    using Next = Run<Tuple, I + 1, J>;
+
+    static bool begin(Tuple& t) { return std::get<I>(t).begin() && Next::begin(t); }
+
+    static inline void process(Tuple& t, float& l, float& r)
+    {
+        std::get<I>(t).process(l, r);
+        Next::process(t, l, r);
+    }
+
+    static void processBlock(Tuple& t, float* l, float* r, int n)
+    {
+        std::get<I>(t).processBlock(l, r, n);
+        Next::processBlock(t, l, r, n);
+    }
+};
+
+template <typename Tuple, std::size_t J>
+struct Run<Tuple, J, J>
+{
+    static bool begin(Tuple&) { return true; }
+    static inline void process(Tuple&, float&, float&) {}
+    static void processBlock(Tuple&, float*, float*, int) {}
+};
+
+// Runs stage I onwards: block stages on their own, per-sample runs fused
+template <typename Tuple, std::size_t I, std::size_t N, bool Done = (I >= N)>
+struct Step
+{
+    using Stage = typename std::tuple_element<I, Tuple>::type;
+    static constexpr std::size_t runEnd = RunEnd<Tuple, I, N>::value;
+
+    static void run(Tuple& t, float* l, float* r, int n)
+    {
+        runStage(t, l, r, n, std::integral_constant<bool, Stage::perSample>());
+    }
+
+    static void runStage(Tuple& t, float* l, float* r, int n, std::false_type)
+    {
+        std::get<I>(t).processBlock(l, r, n);
+        Step<Tuple, I + 1, N>::run(t, l, r, n);
+    }
+
+    static void runStage(Tuple& t, float* l, float* r, int n, std::true_type)
+    {
+        using Fused = Run<Tuple, I, runEnd>;
+
+        if (Fused::begin(t))
+        {
+            // One loop through every stage of the run, the sample stays in registers
+            for (int i = 0; i < n; ++i)
+            {
+                float sl = l[i];
+                float sr = r[i];
+                Fused::process(t, sl, sr);
+                l[i] = sl;
+                r[i] = sr;
+            }
+        }
+        else
+        {
+            Fused::processBlock(t, l, r, n);
+        }
+        Step<Tuple, runEnd, N>::run(t, l, r, n);
+    }
+};
+
+template <typename Tuple, std::size_t I, std::size_t N>
+struct Step<Tuple, I, N, true>
+{
+    static void run(Tuple&, float*, float*, int) {}
+};
+
+} // namespace stagechain
+
+/**
+ * @brief Compile-time composed processing chain, in place on a stereo block.
+ * StageChain<A, B, C> runs A, B, C in that order: order and inclusion are fixed
+ * by the template arguments, so the calls inline and nothing is decided per block
+ * beyond the stages' own begin() checks. Consecutive per-sample stages are fused
+ * into one loop instead of one pass over the buffers each. If any stage of a run
+ * declines (begin() false) the run falls back to processBlock() per stage, with
+ * the same output.
+ */
+template <typename... Stages>
+class StageChain
+{
+public:
+    explicit StageChain(Stages... s) : stages(s...) {}
+
+    void processBlock(float* l, float* r, int n)
+    {
+        stagechain::Step<Tuple, 0, sizeof...(Stages)>::run(stages, l, r, n);
+    }
+
+    /** Same stages as a pass per stage (reference for the fused form). */
+    void processStaged(float* l, float* r, int n)
+    {
+        stagechain::Run<Tuple, 0, sizeof...(Stages)>::processBlock(stages, l, r, n);
+    }
+
+private:
+    using Tuple = std::tuple<Stages...>;
+    Tuple stages;
+};
+
+#endif // DAISY_STAGECHAIN_H
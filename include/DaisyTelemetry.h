@@ -0,0 +1,83 @@
+#pragma once
+#ifndef DAISY_TELEMETRY_H
+#define DAISY_TELEMETRY_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include <cstdint>
+
+// Records held between two drains (power of two). One record per audio block: at
+// block size 4 that is 12000 records/s, so 2048 records cover ~17 control ticks.
+#define TELEMETRY_RING_SIZE 2048
+// Records per serial line (16 hex digits each, keeps lines under the logger's buffer)
+#define TELEMETRY_RECORDS_PER_LINE 6
+// Upper bound on the lines printed per control tick; what doesn't fit waits for the next one
+#define TELEMETRY_MAX_LINES_PER_TICK 40
+
+// Line prefix the host decoder (tools/telemetry_decode.py) looks for
+#define TELEMETRY_LINE_TAG "@T"
+
+/**
+ * @brief Events raised by the modules during a block (TelemetryRecord::events bits).
+ */
+enum TelemetryEvent : uint8_t
+{
+    TELEM_EV_PARAMS_APPLIED = 1 << 0,   // A module installed a staged parameter set
+    TELEM_EV_LOSS_XFADE     = 1 << 1,   // Loss filter started a coefficient crossfade
+    TELEM_EV_FILTER_FADE    = 1 << 2,   // An input filter band started a bypass fade
+    TELEM_EV_DEGRADE_COOK   = 1 << 3,   // Degrade installed its next cooked set (cookParams)
+    TELEM_EV_RING_OVERFLOW  = 1 << 7,   // Records were dropped before this one (ring full)
+};
+
+/**
+ * @brief One audio block, 8 bytes, little endian on the wire.
+ */
+struct TelemetryRecord
+{
+    uint32_t cycles;    // TapeProcessor::processBlock cost (CycleCounter units)
+    uint16_t seq;       // Block counter, wraps. Gaps in the decoded stream = dropped records
+    uint8_t events;     // TelemetryEvent bits raised during the block
+    uint8_t clips;      // Output samples at or beyond full scale (saturates at 255)
+};
+
+/**
+ * @brief Per-block binary telemetry from the audio interrupt.
+ * Lock-free single-producer (interrupt) / single-consumer (main loop) ring:
+ * - note() ORs an event into the current block, endBlock() pushes the record. Both
+ *   are constant time; a full ring drops the record and flags the next one.
+ * - The main loop drains the ring in batches of hex lines (TELEMETRY_LINE_TAG), so
+ *   no float formatting runs anywhere and the interrupt never waits on the serial port.
+ * With DAISYTAPE_TELEMETRY = 0 note() compiles to nothing.
+ */
+class Telemetry
+{
+public:
+    /** Interrupt: raise an event for the current block. */
+    static inline void note(uint8_t event)
+    {
+#if DAISYTAPE_TELEMETRY
+        blockEvents |= event;
+#else
+        (void)event;
+#endif
+    }
+
+    /** Interrupt: close the current block. */
+    static void endBlock(uint32_t cycles, uint32_t clips);
+
+    /** Main thread: print up to TELEMETRY_MAX_LINES_PER_TICK lines of pending records. */
+    static void drain();
+
+    /** Main thread: pops up to maxRecords records into out, returns how many. */
+    static int pop(TelemetryRecord* out, int maxRecords);
+
+private:
+    static TelemetryRecord ring[TELEMETRY_RING_SIZE];
+    static volatile uint32_t head;      // Written by the interrupt only
+    static volatile uint32_t tail;      // Written by the main thread only
+    static uint8_t blockEvents;
+    static uint16_t seq;
+    static bool overflowed;
+};
+
+#endif // DAISY_TELEMETRY_H
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef DAISY_WOWFLUTTER_H
+#define DAISY_WOWFLUTTER_H
+
+#include "Config.h"
+#include "daisy_seed.h"
+#include "DaisyDegrade.h"   // JuceRandom
+#include <cmath>
+#include <cstdint>
+
+// Modulation update period in samples (LFOs and drift run at fs / WF_CONTROL_BLOCK)
+#define WF_CONTROL_BLOCK 32
+
+// Maximum modulation depths (peak, in ms) reached with the depth parameters at 1.0
+#define WF_WOW_MAX_DEPTH_MS     3.0f
+#define WF_FLUTTER_MAX_DEPTH_MS 0.3f
+#define WF_DRIFT_MAX_DEPTH_MS   1.0f
+
+// Highest sample rate the delay ring is sized for
+#define WF_MAX_SAMPLE_RATE 96000
+
+namespace wowflutter {
+    constexpr float maxModDepthMs = WF_WOW_MAX_DEPTH_MS + WF_FLUTTER_MAX_DEPTH_MS + WF_DRIFT_MAX_DEPTH_MS;
+
+    // 4 extra samples cover the Hermite / allpass neighbours
+    constexpr int maxDelaySamples = (int)(2.0f * maxModDepthMs * 0.001f * WF_MAX_SAMPLE_RATE) + 4;
+
+    constexpr int nextPow2(int v, int p = 1) { return p >= v ? p : nextPow2(v, p * 2); }
+}
+
+// Ring size: smallest power of two holding the full modulation swing (1024 samples, 4kB per channel)
+#define WF_DELAY_SIZE (wowflutter::nextPow2(wowflutter::maxDelaySamples))
+
+/**
+ * @brief Fractional delay read method. Measured costs: see DAISYTAPE_BENCHMARK.
+ */
+enum class WowFlutterInterp : int
+{
+    Linear = 0,     // 2 taps, slight HF loss while modulating
+    Hermite,        // 4 taps, flat response
+    Allpass,        // 2 taps + recursion, flat magnitude, one divide per sample
+    NumModes
+};
+
+/**
+ * @brief Wow / flutter stage: a modulated fractional delay.
+ * Wow and flutter LFOs plus a random drift are evaluated every WF_CONTROL_BLOCK
+ * samples; the delay is linearly interpolated between control points per sample.
+ * Both channels share the modulation (one tape transport).
+ * The delay ring is a small member array, so it stays in internal SRAM with the
+ * rest of the processor instead of the SDRAM used for the long latency lines.
+ */
+class WowFlutterProcessor
+{
+public:
+    WowFlutterProcessor();
+    ~WowFlutterProcessor() {}
+
+    void prepare(float sampleRate);
+
+    // Called from main thread: stage new parameters (rates in Hz, depths and drift 0..1)
+    void prepareParams(float wowRate, float wowDepth, float flutterRate, float flutterDepth,
+                       float drift, bool enabled,
+                       WowFlutterInterp interp = WowFlutterInterp::Hermite);
+    // Called from interrupt: apply staged parameters, true when a new set was installed
+    bool applyParams();
+
+    void processBlock(float* bufferL, float* bufferR, int32_t blockSize);
+    // False when processBlock() leaves the audio untouched (stage bypassed, switch-off fade done)
+    bool isActive() const { return onOff; }
+
+    // Centre delay of the modulated line, to be compensated on the dry/makeup paths.
+    // Reported from the start of the switch-on fade to the start of the switch-off one,
+    // so the compensation taps (LatencyTap) fade alongside the wet path
+    float getLatencySamples() const;
+
+private:
+    /**
+     * Switching the stage on or off changes the wet path latency by baseDelay: instead of
+     * a jump, the delayed output crossfades with the direct one over LATENCY_FADE_SAMPLES.
+     * Off -> Filling (ring written, output direct) -> FadingIn -> On -> FadingOut -> Off.
+     */
+    enum class Switch : uint8_t { Off, Filling, FadingIn, On, FadingOut };
+
+    float calcModulation();
+
+    template <WowFlutterInterp I>
+    void processSegment(float* bufferL, float* bufferR, int numSamples, float delayStart, float delayInc);
+    // Outside Switch::On: blends the segment just processed with its direct input, advances the switch
+    void mixSwitch(float* bufferL, float* bufferR, const float* directL, const float* directR, int numSamples);
+
+    float fs;
+
+    // Live values — written only from interrupt (via applyParams)
+    volatile bool onOff;    // Switch state is anything but Off
+    Switch state;
+    int fillLeft;           // Filling: samples until the ring covers the deepest tap
+    int fadeLeft;           // FadingIn / FadingOut: samples left in the crossfade
+    WowFlutterInterp interp;
+    float p_wowRate, p_wowDepth, p_flutterRate, p_flutterDepth, p_drift;
+
+    // Staged values — written from main, consumed by applyParams()
+    float pending_wowRate, pending_wowDepth, pending_flutterRate, pending_flutterDepth, pending_drift;
+    bool pending_onOff;
+    WowFlutterInterp pending_interp;
+    volatile bool paramsDirty;
+
+    // Modulation state (control rate)
+    float wowPhase, flutterPhase;
+    float driftValue, driftTarget, driftCoef;
+    int driftCounter;
+    JuceRandom driftRng;
+    float baseDelay;        // Centre delay in samples
+    float msToSamples;
+    float delayPrev;        // Delay at the previous control point
+    float delayNext;        // Delay at the next control point
+    int controlCounter;
+
+    // Delay ring (internal SRAM)
+    float ring[2][WF_DELAY_SIZE];
+    uint32_t writeIdx;
+    float apState[2];       // Allpass interpolator output history
+};
+
+#endif // DAISY_WOWFLUTTER_H
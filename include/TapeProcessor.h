@@ -7,11 +7,24 @@
 #include "DaisyInputFilters.h" 
 #include "DaisyLossFilter.h" 
 #include "DaisyDegrade.h"
+#include "DaisyHysteresis.h"
+#include "DaisyCompression.h"
+#include "DaisyWowFlutter.h"
+#include "DaisyAzimuthProc.h"
+#include "DaisySaturator.h"
+#include "DaisyChew.h"
+#include "DaisyDropout.h"
+#include "DaisyStageChain.h"
+#include "DaisyGovernor.h"
+#include "DaisyLatencyTap.h"
 #include "daisysp.h" 
 
 // The Dry Delay uses the same massive size needed for latency compensation.
 using DryDelayLine = daisysp::DelayLine<float, MAKEUP_DELAY_SIZE>; 
 
+// Dry/wet ramp length, so the dry path can come and go without clicks
+#define TAPE_MIX_RAMP_MS 20.0f
+
 /**
  * @brief Structure holding all the exposed control parameters for the tape model.
  */
@@ -23,12 +36,43 @@ struct TapeParams
     bool filtersEnabled;
     bool makeupEnabled;
 
+    // Compression
+    float comp_amount;
+    float comp_attack;   // ms
+    float comp_release;  // ms
+    bool comp_enabled;
+
+    // Hysteresis (Tape magnetisation)
+    float hyst_drive;
+    float hyst_saturation;
+    float hyst_bias;
+    bool hyst_enabled;
+    HysteresisSolver hyst_solver;   // Trade accuracy for CPU (see HysteresisSolver)
+
+    // Wow & Flutter
+    float wf_wow_rate;        // Hz
+    float wf_wow_depth;
+    float wf_flutter_rate;    // Hz
+    float wf_flutter_depth;
+    float wf_drift;
+    bool wf_enabled;
+    WowFlutterInterp wf_interp;
+
+    // Saturator (lightweight ADAA alternative to the hysteresis stage)
+    float sat_drive;          // 0..1
+    bool sat_enabled;
+
     // Tape Physics (Loss Filter)
     float speed;     // Inches per second (e.g., 7.5, 15, 30)
     float gap;       // Microns
     float spacing;   // Microns
     float thickness; // Microns
     float loss;      // Not really needed, added just to ease serial logging
+    LossFilterMode loss_mode;   // Linear phase FIR, or its IIR fit (cheaper, zero latency or aligned; latency fixed by Init())
+
+    // Playback head azimuth (uses speed above)
+    float az_angle;  // Degrees, < 0 delays left, > 0 delays right
+    bool az_enabled;
 
     // Degradation (Added)
     float deg_depth;
@@ -38,33 +82,104 @@ struct TapeParams
     bool deg_enabled;
     bool usePoint1x;
 
+    // Chew (random HF loss bursts) and dropout (random level dips), all 0..1
+    float chew_depth;
+    float chew_freq;
+    float chew_variance;
+    bool chew_enabled;
+    float drop_depth;
+    float drop_freq;
+    float drop_variance;
+    bool drop_enabled;
+
     // Global
     float dryWet;
 };
 
+/**
+ * @brief What processBlock() runs (interrupt only). Rebuilt by controlTick() when
+ * a module installs new parameters or the dry/wet mix moves, never per block.
+ */
+struct ProcessingPlan
+{
+    bool inputFilters;
+    bool compression;
+    bool hysteresis;
+    bool chew;
+    bool degrade;
+    bool dropout;
+    bool wowFlutter;
+    bool saturator;
+    bool lossFilter;
+    bool azimuth;
+    bool makeup;
+    bool dryPath;   // Dry copy, delay and mix. Off when fully wet: the output is the wet buffer
+};
+
 /**
  * @brief Main Tape Emulation Processor
  */
 class TapeProcessor
 {
 public:
-    TapeProcessor() : dryWet(1.0f) {}
+    TapeProcessor()
+        : compHyst(CompressionStage{ compression }, HysteresisStage<HysteresisSolver::RK2>{ hysteresis }),
+          stagedValid(false), tier(QualityTier::Full), peakCycles{ 0, 0 }, peakSlot(0),
+          cyclesPerSample(1.0f), controlInterval(DAISYTAPE_CONTROL_INTERVAL),
+          controlCountdown(0), latencySamples(-1.0f),
+          plan(), planDirty(true), mixTarget(1.0f), dryPrimeRemaining(0), dryWet(1.0f) {}
     ~TapeProcessor() {}
 
     void Init(float sampleRate, const TapeParams& params);
 
     /**
      * @brief CRITICAL: Sets the pointers to the globally allocated SDRAM delay lines.
-     * Includes new pointers for the Azimuth/Loss section.
+     * The azimuth delay is a small member line in internal SRAM and needs none.
      */
     void setDelayLinePointers(MakeupDelayLine* makeL, MakeupDelayLine* makeR,
                               DryDelayLine* dryL, DryDelayLine* dryR);
 
     /**
-     * @brief Updates all control parameters from the given structure.
+     * @brief Before Init(): table the loss filter fills with its IIR fits over the knob
+     * space, so IIR settings made with the firmware's knobs skip the fit (see
+     * LossFilter::setIirTable()).
+     */
+    void setLossIirTable(LossIirTable* table) { lossFilter.setIirTable(table); }
+
+    /**
+     * @brief Updates the control parameters from the given structure. Only modules
+     * whose own fields differ from what they were last given are restaged, so an
+     * unchanged structure costs a few compares and no coefficient work.
      */
     void updateParams(const TapeParams& params);
 
+    /**
+     * @brief Main thread: quality tier applied on top of the parameters (see
+     * QualityTier). Restages only the modules the tier changes; set it before Init()
+     * for an offline render at a fixed tier.
+     */
+    void setQualityTier(QualityTier newTier);
+    QualityTier getQualityTier() const { return tier; }
+
+    /**
+     * @brief Main thread: worst processBlock() cost since the last call, as a share of
+     * the block period (1 = the whole audio budget). For CpuGovernor::update().
+     */
+    float takePeakLoad();
+
+    /**
+     * @brief Main-thread coefficient worker: retries any update the interrupt hasn't
+     * taken yet and keeps the degrade stage's next parameter set and the chew and
+     * dropout stages' next random event drawn.
+     * Call from the control loop after updateParams().
+     */
+    void runControlWorker();
+
+    /**
+     * @brief Samples between two control polls in processBlock() (see
+     * DAISYTAPE_CONTROL_INTERVAL), 0 polls every block. Call before audio starts.
+     */
+    void setControlInterval(int samples);
 
     void processBlock(const float* inL,
                       const float* inR,
@@ -72,16 +187,36 @@ public:
                       float* outR,
                       int32_t blockSize);
 
+    /**
+     * @brief Interrupt: installs staged parameter sets and follows the wet path latency.
+     * Runs from processBlock() once every control interval.
+     */
+    void controlTick();
+    void rebuildPlan();
     void latencyCompensation(int32_t blockSize);
     void dryWetMix(float* outL, float* outR, int32_t blockSize);
 
 private:
+    // The parameters the modules get at `tier`
+    static TapeParams applyTier(const TapeParams& params, QualityTier tier);
+    void stageParams(const TapeParams& params);
+
     // --- Processing Modules ---
     InputFilters inputFilters;
     LossFilter lossFilter;
     DegradeProcessor degradeProcessor; // <--- CRITICAL INSTANCE
-    
-    // ... Other modules (Hysteresis, etc.) will go here ...
+    HysteresisProcessor hysteresis;
+    CompressionProcessor compression;
+    WowFlutterProcessor wowFlutter;
+    AzimuthProc azimuth;
+    SaturatorProcessor saturator;
+    ChewProcessor chew;
+    DropoutProcessor dropout;
+
+    // Compression -> hysteresis fused per sample for the default solver (RK2). The
+    // others run as a block pass per stage: no gain was measured that would pay for
+    // one more instantiation of the chain each
+    StageChain<CompressionStage, HysteresisStage<HysteresisSolver::RK2>> compHyst;
 
     // --- Internal Buffers ---
     static constexpr int kMaxBlockSize = SAFE_MAX_BLOCK_SIZE;
@@ -94,8 +229,30 @@ private:
     // --- Dry Path Delay (Pointers to SDRAM) ---
     DryDelayLine* dryDelayL = nullptr;
     DryDelayLine* dryDelayR = nullptr;
+    LatencyTap dryTap;      // Read position of both dry lines (interrupt only)
 
     // --- Parameters ---
+    TapeParams requested;   // Last values given to updateParams() (main thread only)
+    TapeParams staged;      // Last values handed to the modules, tier applied (main thread only)
+    bool stagedValid;       // False until everything has been staged once
+    QualityTier tier;
+
+    // --- Load (CpuGovernor input) ---
+    volatile uint32_t peakCycles[2];    // Worst block, CycleCounter counts per sample; the interrupt writes [peakSlot]
+    volatile int peakSlot;              // Flipped by takePeakLoad()
+    float cyclesPerSample;              // CycleCounter counts in one sample period
+
+    // --- Control polling (interrupt only) ---
+    int controlInterval;    // Samples between two controlTick() calls, 0 = every block
+    int controlCountdown;   // Samples left until the next one
+    float latencySamples;   // Delay last given to the dry and makeup taps
+
+    // --- Processing plan (interrupt only) ---
+    ProcessingPlan plan;
+    bool planDirty;         // Rebuild at the next controlTick()
+    LinSmoothed mix;        // Wet amount actually applied, ramps towards mixTarget
+    float mixTarget;        // Last dryWet seen by controlTick()
+    int dryPrimeRemaining;  // Samples the dry lines still need to refill before the ramp starts
     volatile float dryWet; // written from main, read from interrupt — volatile prevents register caching
 };
 
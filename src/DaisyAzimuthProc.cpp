@@ -1,94 +1,190 @@
 #include "DaisyAzimuthProc.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
+#include <cassert>
 
 // Constants
 namespace {
-    constexpr float inches2meters(float inches) {
-        return inches / 39.370078740157f;
-    }
-
     // Renamed to avoid conflict with libDaisy macro 'deg2rad'
     constexpr float degreesToRadians(float deg) {
         return deg * M_PI / 180.0f;
     }
+}
 
-    // 0.25 inches width converted to meters
-    constexpr float tapeWidth = inches2meters(0.25f);
+AzimuthProc::AzimuthProc()
+    : fs(48000.0f),
+      onOff(false),
+      req_angleDeg(0.0f), req_speedIps(15.0f),
+      req_onOff(false), requestDirty(false)
+{
 }
 
 void AzimuthProc::prepare(float sampleRate)
 {
+    assert(sampleRate <= (float)AZIMUTH_MAX_SAMPLE_RATE);
+
     fs = sampleRate;
 
+    // Audio isn't running yet: drop anything in flight, the latest request is installed below
+    CookedParams c;
+    mailbox.fetch(c);
+    requestDirty = false;
+
+    c = cook();
+    onOff = c.onOff;
+
     for (int ch = 0; ch < 2; ++ch)
     {
-        // Initialize delay lines if pointers are set
-        if(delays[ch] != nullptr) {
-            delays[ch]->Init();
-            // Pre-fill delay with 0s? Init() does this.
-        }
-        
+        delays[ch].Init();
+
         // Initialize smoother (approx 50ms smoothing time)
         delaySampSmooth[ch].Init(sampleRate, 0.05f);
-        
+
         // --- CRITICAL FIX ---
-        // Force the smoother to start at 1.0f immediately.
+        // Force the smoother to start at the target (1.0f = no delay) immediately.
         // This prevents the "sweep from 0" (5.5s delay) artifact on startup.
-        delaySampSmooth[ch].SetCurrent(1.0f);
+        delaySampSmooth[ch].SetCurrent(c.targetDelay[ch]);
     }
 }
 
-void AzimuthProc::setDelayLinePointers(AzimuthDelayLine* delayL, AzimuthDelayLine* delayR)
+void AzimuthProc::prepareParams(float angleDeg, float tapeSpeedIps, bool enabled)
 {
-    delays[0] = delayL;
-    delays[1] = delayR;
+    req_angleDeg = angleDeg;
+    req_speedIps = tapeSpeedIps;
+    req_onOff    = enabled;
+    requestDirty = true;
+
+    runWorker();
 }
 
-void AzimuthProc::setAzimuthAngle(float angleDeg, float tapeSpeedIps)
+void AzimuthProc::runWorker()
 {
+    if (!requestDirty || !mailbox.canPost()) return;
+    if (mailbox.post(cook()))
+        requestDirty = false;
+}
+
+bool AzimuthProc::applyParams()
+{
+    CookedParams c;
+    if (!mailbox.fetch(c)) return false;
+    install(c);
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+    return true;
+}
+
+AzimuthProc::CookedParams AzimuthProc::cook() const
+{
+    CookedParams c;
+    c.onOff = req_onOff;
+
     // If angle < 0, delay Left (idx 0). If angle > 0, delay Right (idx 1).
-    const size_t delayIdx = (angleDeg < 0.0f) ? 0 : 1;
-    
-    const float tapeSpeed = inches2meters(tapeSpeedIps);
-    const float azimuthAngle = degreesToRadians(std::abs(angleDeg));
+    const int delayIdx = (req_angleDeg < 0.0f) ? 0 : 1;
+
+    const float angleDeg = std::min(std::abs(req_angleDeg), AZIMUTH_MAX_ANGLE_DEG);
+    const float speedIps = std::max(req_speedIps, AZIMUTH_MIN_SPEED_IPS);
+
+    const float tapeSpeed = azimuth::inches2meters(speedIps);
+    const float azimuthAngle = degreesToRadians(angleDeg);
 
     // Calculate physical distance offset
-    float delayDist = tapeWidth * std::sin(azimuthAngle);
-    
-    // Calculate raw samples delay
-    auto delaySamp = (delayDist * tapeSpeed) * fs; 
+    float delayDist = azimuth::tapeWidth * std::sin(azimuthAngle);
+
+    // Time for the tape to travel that distance, in samples
+    auto delaySamp = (delayDist / tapeSpeed) * fs;
 
     // --- CRITICAL FIX ---
     // Daisysp::DelayLine::Read(1.0f) = Current Sample (0 latency).
     // Daisysp::DelayLine::Read(0.0f) = Buffer Tail (Max latency).
     // We MUST offset the target by +1.0f.
-    
-    delaySampSmooth[delayIdx].SetTarget(delaySamp + 1.0f);
-    delaySampSmooth[1 - delayIdx].SetTarget(1.0f);
+    c.targetDelay[delayIdx] = delaySamp + 1.0f;
+    c.targetDelay[1 - delayIdx] = 1.0f;
+    return c;
+}
+
+void AzimuthProc::install(const CookedParams& c)
+{
+    const bool wasOn = onOff;
+    onOff = c.onOff;
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        // The lines aren't written while bypassed: restart clean at the new offset
+        if (onOff && !wasOn)
+        {
+            delays[ch].Reset();
+            delaySampSmooth[ch].SetCurrent(c.targetDelay[ch]);
+        }
+        else
+        {
+            delaySampSmooth[ch].SetTarget(c.targetDelay[ch]);
+        }
+    }
 }
 
-void AzimuthProc::processBlock(float* inL, float* inR, float* outL, float* outR, int32_t blockSize)
+DAISYTAPE_ITCM void AzimuthProc::processBlock(float* inL, float* inR, float* outL, float* outR, int32_t blockSize)
 {
     float* inputs[2] = {inL, inR};
     float* outputs[2] = {outL, outR};
 
+    if (!onOff)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            if (outputs[ch] != inputs[ch])
+                std::copy(inputs[ch], inputs[ch] + blockSize, outputs[ch]);
+        return;
+    }
+
     for (int ch = 0; ch < 2; ++ch)
+        processChannel(ch, inputs[ch], outputs[ch], blockSize);
+}
+
+DAISYTAPE_ITCM void AzimuthProc::processChannel(int ch, const float* in, float* out, int32_t blockSize)
+{
+    AzimuthDelayLine& line = delays[ch];
+
+    // Block-rate smoothing: ramp from the value at the end of the last block to this one's
+    const float startDelay = delaySampSmooth[ch].GetCurrent();
+    const float endDelay = delaySampSmooth[ch].ProcessBlock(blockSize);
+
+    if (startDelay != endDelay)
     {
-        // Safety check
-        if (delays[ch] == nullptr) {
-            for(int i=0; i<blockSize; i++) outputs[ch][i] = inputs[ch][i];
-            continue;
+        const float inc = (endDelay - startDelay) / (float)blockSize;
+        float currentDelay = startDelay;
+        for (int32_t n = 0; n < blockSize; ++n)
+        {
+            currentDelay += inc;
+            line.Write(in[n]);
+            out[n] = line.ReadHermite(currentDelay);
         }
+        return;
+    }
 
-        for (int n = 0; n < blockSize; ++n)
+    // Settled
+    if (endDelay == 1.0f)
+    {
+        // Read(1.0f) is the sample just written: keep the history, pass the input through
+        for (int32_t n = 0; n < blockSize; ++n)
+            line.Write(in[n]);
+        if (out != in)
+            std::copy(in, in + blockSize, out);
+    }
+    else if (endDelay == std::floor(endDelay))
+    {
+        const size_t delayInt = (size_t)endDelay;
+        line.SetDelay(delayInt);
+        for (int32_t n = 0; n < blockSize; ++n)
+        {
+            line.Write(in[n]);
+            out[n] = line.Read();
+        }
+    }
+    else
+    {
+        for (int32_t n = 0; n < blockSize; ++n)
         {
-            // Update smoothed delay time
-            float currentDelay = delaySampSmooth[ch].Process();
-            
-            // Write input sample
-            delays[ch]->Write(inputs[ch][n]);
-            
-            // Read with Hermite (Cubic) interpolation
-            outputs[ch][n] = delays[ch]->ReadHermite(currentDelay);
+            line.Write(in[n]);
+            out[n] = line.ReadHermite(endDelay);
         }
     }
-}
\ No newline at end of file
+}
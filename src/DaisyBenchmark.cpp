@@ -0,0 +1,1194 @@
+#include "DaisyBenchmark.h"
+#include "DaisyCycleCounter.h"
+#include "DaisyHysteresis.h"
+#include "DaisyCompression.h"
+#include "DaisyWowFlutter.h"
+#include "DaisyDegrade.h"
+#include "DaisyFastMath.h"
+#include "DaisyLossFilter.h"
+#include "DaisyInputFilters.h"
+#include "DaisyLinkwitzRiley.h"
+#include "DaisyCrossover.h"
+#include "DaisyAzimuthProc.h"
+#include "DaisyDenormals.h"
+#include "DaisyStageChain.h"
+#include "DaisySaturator.h"
+#include "DaisyChew.h"
+#include "DaisyDropout.h"
+#include "DaisyGovernor.h"
+#include "daisy_seed.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace daisy;
+
+namespace {
+    constexpr int benchBlockSize = 48;
+    constexpr int benchNumBlocks = 200;
+
+    float benchL[benchBlockSize];
+    float benchR[benchBlockSize];
+
+    // Checks against a stated bound. A miss prints FAIL and is counted, and
+    // runBenchmarks() ends with the count, so a regression can't hide in the numbers
+    int benchFailures = 0;
+
+    bool benchCheck(bool ok, const char* what)
+    {
+        if (!ok)
+        {
+            ++benchFailures;
+            DaisySeed::PrintLine("FAIL: %s", what);
+        }
+        return ok;
+    }
+
+    // Fused and staged degrade (same cooked parameters): rounding only
+    constexpr float degradeTolerance = 1.0e-6f;
+
+    // StageChain fused vs staged: the same per-sample code, so rounding only (operation
+    // contraction may differ between the two inlining contexts)
+    constexpr float chainTolerance = 1.0e-6f;
+
+    // LR4 low + high against the exact allpass while the cutoff glides: the
+    // per-sample Newton-Raphson h may drift, but stays below -80 dBFS
+    constexpr double lrGlideTolerance = 1.0e-4;
+
+    // Loss IIR from the knob-space table against a direct fit: passband error at most
+    // this much worse (interpolated shelves refined for LOSS_TABLE_REFINE_ITERATIONS)
+    constexpr float lossTableExcessDB = 1.5f;
+
+    // Crossover sum with the aligned bands: flat within 0.01 dB
+    constexpr float crossoverFlatnessDB = 0.01f;
+
+    // Fills the bench buffers with a -6 dBFS stereo sine pair, continuing the phase across blocks
+    void fillSine(int blockIdx, float sampleRate)
+    {
+        for (int n = 0; n < benchBlockSize; ++n)
+        {
+            const float t = (float)(blockIdx * benchBlockSize + n) / sampleRate;
+            benchL[n] = 0.5f * std::sin(2.0f * (float)M_PI * 440.0f * t);
+            benchR[n] = 0.5f * std::sin(2.0f * (float)M_PI * 660.0f * t);
+        }
+    }
+
+    // Runs `process` over benchNumBlocks blocks and returns the average cost per sample
+    template <typename Fn>
+    uint32_t measurePerSample(float sampleRate, Fn process)
+    {
+        uint32_t total = 0;
+        for (int b = 0; b < benchNumBlocks; ++b)
+        {
+            fillSine(b, sampleRate);
+            const uint32_t start = CycleCounter::Now();
+            process(benchL, benchR, benchBlockSize);
+            total += CycleCounter::Elapsed(start);
+        }
+        return total / (uint32_t)(benchNumBlocks * benchBlockSize);
+    }
+
+    void benchHysteresis(float sampleRate)
+    {
+        static HysteresisProcessor hyst;
+        static const char* names[] = { "RK2", "RK4", "NR4" };
+
+        for (int s = 0; s < (int)HysteresisSolver::NumSolvers; ++s)
+        {
+            hyst.prepare(sampleRate);
+            hyst.prepareParams(0.5f, 0.5f, 0.5f, true, (HysteresisSolver)s);
+            hyst.applyParams();
+
+            const uint32_t cost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                hyst.processBlock(l, r, n);
+            });
+            DaisySeed::PrintLine("Hysteresis %s: %u %s/sample", names[s], (unsigned)cost, CycleCounter::Unit());
+        }
+    }
+
+    void benchCompression(float sampleRate)
+    {
+        static CompressionProcessor comp;
+        comp.prepare(sampleRate);
+        comp.prepareParams(0.75f, 5.0f, 100.0f, true);
+        comp.applyParams();
+
+        const uint32_t cost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            comp.processBlock(l, r, n);
+        });
+        DaisySeed::PrintLine("Compression: %u %s/sample", (unsigned)cost, CycleCounter::Unit());
+    }
+
+    void benchWowFlutter(float sampleRate)
+    {
+        static WowFlutterProcessor wf;
+        static const char* names[] = { "linear", "Hermite", "allpass" };
+
+        for (int i = 0; i < (int)WowFlutterInterp::NumModes; ++i)
+        {
+            wf.prepare(sampleRate);
+            wf.prepareParams(0.5f, 0.5f, 8.0f, 0.5f, 0.5f, true, (WowFlutterInterp)i);
+            wf.applyParams();
+
+            const uint32_t cost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                wf.processBlock(l, r, n);
+            });
+            DaisySeed::PrintLine("Wow/flutter %s: %u %s/sample", names[i], (unsigned)cost, CycleCounter::Unit());
+        }
+    }
+
+    // Draws from `lanes` (nextFloat() and odd-length fillFloats()) against `serial`,
+    // bit for bit. False on the first mismatch
+    bool noiseMatches(JuceRandom& serial, JuceRandomLanes<DEG_RNG_LANES>& lanes)
+    {
+        static const int fills[] = { 1, 3, DEG_RNG_LANES - 1, DEG_RNG_LANES, 2 * DEG_RNG_LANES + 5, 37, 257 };
+        float out[257];
+        for (int len : fills)
+        {
+            lanes.fillFloats(out, len);
+            for (int i = 0; i < len; ++i)
+                if (out[i] != serial.nextFloat()) return false;
+            if (lanes.nextFloat() != serial.nextFloat()) return false;
+        }
+        return true;
+    }
+
+    // The lane generator and skip() against JuceRandom's own sequence: same values
+    // across seeds and odd lengths, skip(n) equal to n discarded draws (both classes),
+    // and a skip over the whole 2^48 period landing back on the same value, which only
+    // a jump-ahead can do in time
+    void checkNoiseSequences()
+    {
+        static const uint64_t seeds[] = { 1ull, 0x1000ull, 0x12345678abcdefull, ~0ull };
+        static const uint64_t skips[] = { 0, 1, 5, DEG_RNG_LANES, 3 * DEG_RNG_LANES + 1, 1000, 12345 };
+
+        bool lanesOk = true, skipOk = true, periodOk = true;
+        for (uint64_t seed : seeds)
+        {
+            JuceRandom serial(seed);
+            JuceRandomLanes<DEG_RNG_LANES> lanes(seed);
+            lanesOk &= noiseMatches(serial, lanes);
+
+            for (uint64_t n : skips)
+            {
+                JuceRandom reference(seed), jumped(seed);
+                JuceRandomLanes<DEG_RNG_LANES> laneJumped(seed);
+                laneJumped.nextFloat();     // Mid-group
+                reference.nextFloat();
+                jumped.nextFloat();
+                for (uint64_t i = 0; i < n; ++i)
+                    reference.nextFloat();
+                jumped.skip(n);
+                laneJumped.skip(n);
+
+                JuceRandom copy = reference;
+                for (int i = 0; i < 16; ++i)
+                    skipOk &= jumped.nextFloat() == copy.nextFloat();
+                skipOk &= noiseMatches(reference, laneJumped);
+            }
+
+            JuceRandom wrapped(seed), plain(seed);
+            JuceRandomLanes<DEG_RNG_LANES> laneWrapped(seed);
+            wrapped.skip(1ull << 48);
+            laneWrapped.skip(1ull << 48);
+            JuceRandom copy = plain;
+            for (int i = 0; i < 16; ++i)
+                periodOk &= wrapped.nextFloat() == copy.nextFloat();
+            periodOk &= noiseMatches(plain, laneWrapped);
+        }
+        benchCheck(lanesOk, "JuceRandomLanes vs JuceRandom");
+        benchCheck(skipOk, "noise skip(n) vs n draws");
+        benchCheck(periodOk, "noise skip over the full period");
+    }
+
+    void benchNoise(float sampleRate)
+    {
+        checkNoiseSequences();
+
+        static JuceRandom serialRng(1);
+        static JuceRandomLanes<DEG_RNG_LANES> laneRng(1);
+
+        const uint32_t serialCost = measurePerSample(sampleRate, [](float* l, float*, int n) {
+            for (int i = 0; i < n; ++i)
+                l[i] = serialRng.nextFloat();
+        });
+        const uint32_t laneCost = measurePerSample(sampleRate, [](float* l, float*, int n) {
+            laneRng.fillFloats(l, n);
+        });
+        DaisySeed::PrintLine("Noise serial: %u %s/sample, %d lanes: %u %s/sample",
+                             (unsigned)serialCost, CycleCounter::Unit(), DEG_RNG_LANES,
+                             (unsigned)laneCost, CycleCounter::Unit());
+    }
+
+#if DAISYTAPE_BENCHMARK
+    // Fused degrade kernel against its pre-fusion form (processBlockStaged): two
+    // processors with the same settings cook the same parameter sets, so their outputs
+    // must match to rounding, with the envelope on and off, across several cooks
+    void benchDegrade(float sampleRate)
+    {
+        static DegradeProcessor staged;
+        static DegradeProcessor fused;
+        static float refL[benchBlockSize], refR[benchBlockSize];
+        static const float envelopes[] = { 0.5f, 0.0f };
+
+        for (float envelope : envelopes)
+        {
+            staged.prepare(sampleRate);
+            fused.prepare(sampleRate);
+            staged.prepareParams(0.5f, 0.5f, 0.5f, envelope, true);
+            fused.prepareParams(0.5f, 0.5f, 0.5f, envelope, true);
+            staged.applyParams();
+            fused.applyParams();
+
+            float maxDiff = 0.0f;
+            for (int b = 0; b < benchNumBlocks; ++b)
+            {
+                fillSine(b, sampleRate);
+                std::memcpy(refL, benchL, sizeof(refL));
+                std::memcpy(refR, benchR, sizeof(refR));
+                staged.runWorker();
+                fused.runWorker();
+                staged.processBlockStaged(refL, refR, benchBlockSize);
+                fused.processBlock(benchL, benchR, benchBlockSize);
+                for (int i = 0; i < benchBlockSize; ++i)
+                    maxDiff = std::fmax(maxDiff, std::fmax(std::fabs(benchL[i] - refL[i]), std::fabs(benchR[i] - refR[i])));
+            }
+            benchCheck(maxDiff <= degradeTolerance, "degrade fused vs staged");
+
+            const uint32_t stagedCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                staged.processBlockStaged(l, r, n);
+            });
+            const uint32_t fusedCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                fused.processBlock(l, r, n);
+            });
+            DaisySeed::PrintLine("Degrade envelope %s: staged %u, fused %u %s/sample, max diff %u ppb",
+                                 envelope > 0.0f ? "on" : "off",
+                                 (unsigned)stagedCost, (unsigned)fusedCost, CycleCounter::Unit(),
+                                 (unsigned)(maxDiff * 1.0e9f));
+        }
+    }
+#endif
+
+    // The azimuth stage as it was before the delay moved into SRAM: same smoother and
+    // Hermite read, over 2^18-sample lines in SDRAM
+    using AzimuthSdramLine = daisysp::DelayLine<float, 262144>;
+    AzimuthSdramLine DSY_SDRAM_BSS azimuthSdramL;
+    AzimuthSdramLine DSY_SDRAM_BSS azimuthSdramR;
+
+    struct AzimuthSdramReference
+    {
+        AzimuthSdramLine* delays[2] = { &azimuthSdramL, &azimuthSdramR };
+        AzimuthSmoother smooth[2];
+
+        void prepare(float sampleRate, float delayL, float delayR)
+        {
+            const float delay[2] = { delayL, delayR };
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                delays[ch]->Init();
+                smooth[ch].Init(sampleRate, 0.05f);
+                smooth[ch].SetCurrent(delay[ch]);
+            }
+        }
+
+        void process(float* l, float* r, int numSamples)
+        {
+            float* io[2] = { l, r };
+            for (int ch = 0; ch < 2; ++ch)
+                for (int n = 0; n < numSamples; ++n)
+                {
+                    const float d = smooth[ch].Process();
+                    delays[ch]->Write(io[ch][n]);
+                    io[ch][n] = delays[ch]->ReadHermite(d);
+                }
+        }
+    };
+
+    // Azimuth stage with its delay in internal SRAM vs the former SDRAM lines (which also
+    // ran the smoother and the Hermite read per sample on both channels). Settled, both
+    // read at the same delays, so the outputs only differ by the rounding of the delay.
+    void benchAzimuth(float sampleRate)
+    {
+        static AzimuthProc sram;
+        static AzimuthSdramReference sdram;
+        static float refL[benchBlockSize], refR[benchBlockSize];
+        constexpr float angleDeg = 0.5f, speedIps = 15.0f;
+
+        sram.prepare(sampleRate);
+        sram.prepareParams(angleDeg, speedIps, true);
+        sram.applyParams();
+        const float delaySamp = azimuth::tapeWidth * std::sin(angleDeg * (float)M_PI / 180.0f)
+                              / azimuth::inches2meters(speedIps) * sampleRate + 1.0f;
+        sdram.prepare(sampleRate, 1.0f, delaySamp);
+
+        const uint32_t sdramCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            sdram.process(l, r, n);
+        });
+        const uint32_t sramCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            sram.processBlock(l, r, l, r, n);
+        });
+
+        // Both channels settled at 1.0 (copy path), then a 0 -> max angle move that
+        // keeps ramping for the whole measurement
+        sram.prepareParams(0.0f, speedIps, true);
+        sram.prepare(sampleRate);
+        const uint32_t zeroCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            sram.processBlock(l, r, l, r, n);
+        });
+        sram.prepareParams(AZIMUTH_MAX_ANGLE_DEG, speedIps, true);
+        sram.applyParams();
+        const uint32_t rampCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            sram.processBlock(l, r, l, r, n);
+        });
+
+        // Fresh state for the output comparison (settled, so no ramp on either side)
+        sram.prepareParams(angleDeg, speedIps, true);
+        sram.prepare(sampleRate);
+        sdram.prepare(sampleRate, 1.0f, delaySamp);
+        float maxDiff = 0.0f;
+        for (int b = 0; b < benchNumBlocks; ++b)
+        {
+            fillSine(b, sampleRate);
+            std::memcpy(refL, benchL, sizeof(refL));
+            std::memcpy(refR, benchR, sizeof(refR));
+            sram.processBlock(benchL, benchR, benchL, benchR, benchBlockSize);
+            sdram.process(refL, refR, benchBlockSize);
+            for (int i = 0; i < benchBlockSize; ++i)
+                maxDiff = std::fmax(maxDiff, std::fmax(std::fabs(benchL[i] - refL[i]), std::fabs(benchR[i] - refR[i])));
+        }
+        const unsigned centiSamples = (unsigned)((delaySamp - 1.0f) * 100.0f);
+        DaisySeed::PrintLine("Azimuth %u.%02u samples: SDRAM %u, SRAM %u %s/sample, max diff %u ppb",
+                             centiSamples / 100, centiSamples % 100, (unsigned)sdramCost, (unsigned)sramCost,
+                             CycleCounter::Unit(), (unsigned)(maxDiff * 1.0e9f));
+        DaisySeed::PrintLine("Azimuth 0 degrees (copy): %u, ramping: %u %s/sample",
+                             (unsigned)zeroCost, (unsigned)rampCost, CycleCounter::Unit());
+    }
+
+    // Input filters with both bands active vs at the default (auto-bypassed) cutoffs
+    void benchInputFilters(float sampleRate)
+    {
+        static InputFilters filters;
+        static const float cutoffs[2][2] = { { 100.0f, 10000.0f }, { 5.0f, 24000.0f } };
+        static const char* names[2] = { "active", "auto-bypassed" };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            filters.prepare(sampleRate, 2);
+            filters.prepareParams(cutoffs[i][0], cutoffs[i][1], true, false);
+            filters.applyParams();
+
+            const uint32_t cost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                filters.processBlock(l, r, n);
+            });
+            DaisySeed::PrintLine("Input filters %s: %u %s/sample", names[i], (unsigned)cost, CycleCounter::Unit());
+        }
+    }
+
+    // Allpass check for Linkwitz-Riley cutoff glides: low + high of an LR4 must equal the
+    // 2nd-order TPT allpass x - 2 R2 yB with the same g trajectory. The reference below
+    // runs that SVF with an exact 1 / (1 + R2 g + g^2) per sample, so the error shows how
+    // far the per-sample Newton-Raphson h drifts from exact while the cutoff moves.
+    // Fails above lrGlideTolerance.
+    void benchLinkwitzRileyGlide(float sampleRate)
+    {
+        static LinkwitzRileyFilter<float> lr;
+        constexpr float R2 = 1.41421356237f;
+        constexpr int glideLen = INPUT_FILTERS_GLIDE_SAMPLES;
+        constexpr int numSamples = 48000;
+        const float cutoffs[] = { 20.0f, 12000.0f, 200.0f, 5000.0f, 40.0f, 18000.0f };
+
+        lr.prepare(sampleRate, 1);
+        float g, h;
+        LinkwitzRileyFilter<float>::calcCoefs(cutoffs[0], sampleRate, g, h);
+        lr.setCoefs(cutoffs[0], g, h);
+
+        float gRef = g, gStep = 0.0f, gTarget = g;
+        int remaining = 0;
+        float s1 = 0.0f, s2 = 0.0f;
+        double maxErr = 0.0;
+        uint32_t cycles = 0;
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            if (n % glideLen == 0)
+            {
+                // Jump across the band every glide: far faster than any knob
+                const float fc = cutoffs[(n / glideLen) % 6];
+                LinkwitzRileyFilter<float>::calcCoefs(fc, sampleRate, g, h);
+                lr.glideTo(fc, g, h, glideLen);
+                gTarget = g;
+                gStep = (g - gRef) / (float)glideLen;
+                remaining = glideLen;
+            }
+
+            const float x = 0.5f * std::sin(2.0f * (float)M_PI * 997.0f * (float)n / sampleRate)
+                          + 0.25f * std::sin(2.0f * (float)M_PI * 61.0f * (float)n / sampleRate);
+
+            float lo, hi;
+            const uint32_t start = CycleCounter::Now();
+            lr.tick();
+            lr.processSample(0, x, lo, hi);
+            cycles += CycleCounter::Elapsed(start);
+
+            gRef = (--remaining == 0) ? gTarget : gRef + gStep;
+            const float hRef = 1.0f / (1.0f + R2 * gRef + gRef * gRef);
+            const float yH = (x - (R2 + gRef) * s1 - s2) * hRef;
+            const float tB = gRef * yH;
+            const float yB = tB + s1;
+            s1 = tB + yB;
+            const float tL = gRef * yB;
+            const float yL = tL + s2;
+            s2 = tL + yL;
+            const float ap = x - 2.0f * R2 * yB;
+
+            const double err = std::fabs((double)(lo + hi) - (double)ap);
+            if (err > maxErr) maxErr = err;
+        }
+
+        DaisySeed::PrintLine("LR4 glide: allpass error %u ppb of full scale (bound %u), %u %s/sample (tick + process)",
+                             (unsigned)(maxErr * 1.0e9), (unsigned)(lrGlideTolerance * 1.0e9),
+                             (unsigned)(cycles / numSamples), CycleCounter::Unit());
+        benchCheck(maxErr <= lrGlideTolerance, "LR4 glide allpass");
+    }
+
+#if DAISYTAPE_CROSSOVER
+    // N-band crossover: split + sum cost per band, and the flatness of the recombined
+    // output with band 0 delayed by a fake 37-sample "chain" (exercises the alignment),
+    // which must stay within crossoverFlatnessDB. Only built with DAISYTAPE_CROSSOVER
+    void benchCrossover(float sampleRate)
+    {
+        static CrossoverEngine xover;
+        static float delayRing[64][2];
+        constexpr int bandDelay = 37;
+        static const float crossoverHz[XOVER_MAX_BANDS - 1] = { 250.0f, 2500.0f, 8000.0f };
+        const float testHz[] = { 100.0f, 250.0f, 1000.0f, 2500.0f, 8000.0f };
+
+        for (int numBands = 2; numBands <= XOVER_MAX_BANDS; ++numBands)
+        {
+            xover.prepare(sampleRate);
+            xover.prepareParams(numBands, crossoverHz);
+            xover.applyParams();
+
+            const uint32_t cost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                xover.split(l, r, n);
+                xover.sum(l, r, n);
+            });
+
+            // Flatness: steady-state RMS out / in for a few sines across the crossovers
+            float worstDevDB = 0.0f;
+            for (float hz : testHz)
+            {
+                xover.prepare(sampleRate);
+                xover.prepareParams(numBands, crossoverHz);
+                xover.applyParams();
+                std::memset(delayRing, 0, sizeof(delayRing));
+
+                double inPow = 0.0, outPow = 0.0;
+                for (int b = 0; b < benchNumBlocks; ++b)
+                {
+                    for (int i = 0; i < benchBlockSize; ++i)
+                        benchL[i] = benchR[i] = std::sin(2.0f * (float)M_PI * hz * (float)(b * benchBlockSize + i) / sampleRate);
+                    if (b >= benchNumBlocks / 2)
+                        for (int i = 0; i < benchBlockSize; ++i)
+                            inPow += benchL[i] * benchL[i];
+
+                    xover.split(benchL, benchR, benchBlockSize);
+                    float* band0[2] = { xover.bandL(0), xover.bandR(0) };
+                    for (int i = 0; i < benchBlockSize; ++i)
+                    {
+                        const int w = (b * benchBlockSize + i) & 63;
+                        for (int ch = 0; ch < 2; ++ch)
+                        {
+                            delayRing[w][ch] = band0[ch][i];
+                            band0[ch][i] = delayRing[(w - bandDelay) & 63][ch];
+                        }
+                    }
+                    xover.setBandLatency(0, (float)bandDelay);
+                    xover.sum(benchL, benchR, benchBlockSize);
+
+                    if (b >= benchNumBlocks / 2)
+                        for (int i = 0; i < benchBlockSize; ++i)
+                            outPow += benchL[i] * benchL[i];
+                }
+                const float devDB = std::fabs(10.0f * std::log10((float)(outPow / inPow)));
+                worstDevDB = std::fmax(worstDevDB, devDB);
+            }
+
+            DaisySeed::PrintLine("Crossover %d bands: %u %s/sample (%u per band), flatness %u mdB",
+                                 numBands, (unsigned)cost, CycleCounter::Unit(),
+                                 (unsigned)(cost / numBands), (unsigned)(worstDevDB * 1000.0f));
+            benchCheck(worstDevDB <= crossoverFlatnessDB && !xover.wasAlignmentClamped(), "crossover flatness");
+        }
+
+        // A band latency the align lines can't hold must be reported
+        xover.prepare(sampleRate);
+        xover.setBandLatency(0, (float)XOVER_ALIGN_SIZE);
+        xover.sum(benchL, benchR, benchBlockSize);
+        benchCheck(xover.wasAlignmentClamped(), "crossover alignment clamp reported");
+    }
+#endif
+
+    // Accuracy and cost of one FastMath function against libm. The error is taken over
+    // numCheckPoints points spanning [lo, hi] against the double-precision reference,
+    // and must stay within `bound` (the DaisyFastMath.h table). The cost is the average
+    // per call over a numPoints sweep (float libm vs FastMath).
+    template <typename Fast, typename Ref, typename RefD>
+    void benchMathFunc(const char* name, float lo, float hi, bool relative, double bound,
+                       Fast fast, Ref ref, RefD refD)
+    {
+        constexpr int numPoints = 4096;
+        constexpr int numCheckPoints = 1 << 18;
+        double maxErr = 0.0;
+        for (int i = 0; i < numCheckPoints; ++i)
+        {
+            const float x = lo + (hi - lo) * (float)i / (float)(numCheckPoints - 1);
+            const double r = refD((double)x);
+            double err = std::fabs((double)fast(x) - r);
+            if (relative && r != 0.0) err /= std::fabs(r);
+            if (err > maxErr) maxErr = err;
+        }
+
+        volatile float sink = 0.0f;
+        uint32_t start = CycleCounter::Now();
+        for (int i = 0; i < numPoints; ++i)
+            sink = sink + ref(lo + (hi - lo) * (float)i / (float)(numPoints - 1));
+        const uint32_t refCost = CycleCounter::Elapsed(start) / numPoints;
+
+        start = CycleCounter::Now();
+        for (int i = 0; i < numPoints; ++i)
+            sink = sink + fast(lo + (hi - lo) * (float)i / (float)(numPoints - 1));
+        const uint32_t fastCost = CycleCounter::Elapsed(start) / numPoints;
+
+        DaisySeed::PrintLine("  %-8s err %u ppb (%s, bound %u), libm %u, fast %u %s/call", name,
+                             (unsigned)(maxErr * 1.0e9), relative ? "rel" : "abs", (unsigned)(bound * 1.0e9),
+                             (unsigned)refCost, (unsigned)fastCost, CycleCounter::Unit());
+        benchCheck(maxErr <= bound, name);
+    }
+
+    // Every DaisyFastMath.h function over its documented domain, against its documented
+    // bound (log2 and gainToDb over 12 decades: the error doesn't depend on the exponent)
+    void benchFastMath()
+    {
+        DaisySeed::PrintLine("FastMath vs libm:");
+        benchMathFunc("log2", 1.0e-6f, 1.0e6f, false, 1.1e-5,
+                      [](float x) { return FastMath::log2(x); }, [](float x) { return std::log2(x); },
+                      [](double x) { return std::log2(x); });
+        benchMathFunc("exp2", -126.0f, 126.0f, true, 2.8e-6,
+                      [](float x) { return FastMath::exp2(x); }, [](float x) { return std::exp2(x); },
+                      [](double x) { return std::exp2(x); });
+        benchMathFunc("exp", -87.0f, 87.0f, true, 6.5e-6,
+                      [](float x) { return FastMath::exp(x); }, [](float x) { return std::exp(x); },
+                      [](double x) { return std::exp(x); });
+        benchMathFunc("pow", 0.01f, 100.0f, true, 5.5e-6 * 1.8,
+                      [](float x) { return FastMath::pow(x, 0.8f); }, [](float x) { return std::pow(x, 0.8f); },
+                      [](double x) { return std::pow(x, 0.8); });
+        benchMathFunc("dbToGain", -700.0f, 700.0f, true, 5.6e-6,
+                      [](float x) { return FastMath::dbToGain(x); }, [](float x) { return std::pow(10.0f, x / 20.0f); },
+                      [](double x) { return std::pow(10.0, x / 20.0); });
+        benchMathFunc("gainToDb", 1.0e-6f, 1.0e6f, false, 6.5e-5,
+                      [](float x) { return FastMath::gainToDb(x); }, [](float x) { return 20.0f * std::log10(x); },
+                      [](double x) { return 20.0 * std::log10(x); });
+        benchMathFunc("sin", -8192.0f, 8192.0f, false, 1.1e-6,
+                      [](float x) { return FastMath::sin(x); }, [](float x) { return std::sin(x); },
+                      [](double x) { return std::sin(x); });
+        benchMathFunc("cos", -8192.0f, 8192.0f, false, 1.1e-6,
+                      [](float x) { return FastMath::cos(x); }, [](float x) { return std::cos(x); },
+                      [](double x) { return std::cos(x); });
+        benchMathFunc("tan", 0.0f, 1.52f, true, 3.3e-6,
+                      [](float x) { return FastMath::tan(x); }, [](float x) { return std::tan(x); },
+                      [](double x) { return std::tan(x); });
+    }
+
+    // Main-thread cost of one loss filter design (FIR + head bump, via prepare()) with
+    // the current DAISYTAPE_FASTMATH_LOSS setting
+    void benchLossDesign(float sampleRate)
+    {
+        static LossFilter loss;
+
+        uint32_t total = 0;
+        constexpr int numDesigns = 16;
+        for (int i = 0; i < numDesigns; ++i)
+        {
+            const uint32_t start = CycleCounter::Now();
+            loss.prepare(sampleRate);
+            total += CycleCounter::Elapsed(start);
+        }
+        DaisySeed::PrintLine("Loss filter redesign (fast math %d): %u %s", DAISYTAPE_FASTMATH_LOSS,
+                             (unsigned)(total / numDesigns), CycleCounter::Unit());
+    }
+
+    // Loss filter FIR against its IIR approximation (zero latency, and aligned to the
+    // FIR's): cost per sample once the crossfade has finished, main-thread cost of a
+    // redesign (FIR design + fit), and the fit error (max / RMS / max above
+    // LOSS_IIR_PASSBAND_DB) over the loss pots (the DaisyTape mapping) at a few tape speeds.
+    // Then the knob-space table: cost of filling it, and redesigns between its grid
+    // points against direct fits (cost, worst passband error added)
+    void benchLossIir(float sampleRate)
+    {
+        static LossFilter loss;
+        static LossFilter direct;
+        static LossIirTable table;
+        static const char* const modeNames[] = { "FIR", "IIR", "IIR aligned" };
+        const float speeds[] = { 1.875f, 3.75f, 7.5f, 15.0f, 30.0f };
+        constexpr int numPots = 5;
+
+        for (int m = 0; m < (int)LossFilterMode::NumModes; ++m)
+        {
+            const LossFilterMode mode = (LossFilterMode)m;
+            loss.prepare(sampleRate, mode);
+            const uint32_t start = CycleCounter::Now();
+            loss.prepareParams(7.5f, 10.05f, 25.05f, 25.5f, mode);
+            const uint32_t design = CycleCounter::Elapsed(start);
+            loss.applyParams();
+            for (int b = 0; b * benchBlockSize <= LOSS_FADE_LEN; ++b)
+                loss.processBlock(benchL, benchR, benchL, benchR, benchBlockSize);
+
+            const uint32_t cost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                loss.processBlock(l, r, l, r, n);
+            });
+            DaisySeed::PrintLine("Loss %s: %u %s/sample, latency %d samples, redesign %u %s",
+                                 modeNames[m], (unsigned)cost,
+                                 CycleCounter::Unit(), (int)loss.getLatencySamples(),
+                                 (unsigned)design, CycleCounter::Unit());
+        }
+
+        // Started on the FIR, an IIR request runs aligned: the latency doesn't move
+        loss.prepare(sampleRate);
+        loss.prepareParams(7.5f, 10.05f, 25.05f, 25.5f, LossFilterMode::IIR);
+        loss.applyParams();
+        for (int b = 0; b * benchBlockSize <= LOSS_FADE_LEN; ++b)
+            loss.processBlock(benchL, benchR, benchL, benchR, benchBlockSize);
+        benchCheck(loss.getLatencySamples() == (float)LOSS_FIR_ORDER / 2.0f, "loss latency held across a switch to IIR");
+
+        for (float speed : speeds)
+        {
+            for (int i = 0; i < numPots; ++i)
+            {
+                const float p = (float)i / (float)(numPots - 1);
+                float spacing, thickness, gap;
+                LossFilter::lossKnob(p, spacing, thickness, gap);
+                loss.prepare(sampleRate, LossFilterMode::IIR);
+                loss.prepareParams(speed, spacing, thickness, gap, LossFilterMode::IIR);
+                float maxDb, rmsDb, passDb;
+                loss.getIirFitError(maxDb, rmsDb, passDb);
+                DaisySeed::PrintLine("Loss IIR fit %u.%03u ips, loss %u%%: max %u, rms %u, passband %u mdB",
+                                     (unsigned)speed, (unsigned)(speed * 1000.0f) % 1000, (unsigned)(p * 100.0f),
+                                     (unsigned)(maxDb * 1000.0f), (unsigned)(rmsDb * 1000.0f),
+                                     (unsigned)(passDb * 1000.0f));
+            }
+        }
+
+        loss.setIirTable(&table);
+        loss.prepare(sampleRate, LossFilterMode::IIR);
+        uint64_t fillTotal = 0;     // Seconds of cycles in all: summed per entry
+        while (table.filled < LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES)
+        {
+            const uint32_t start = CycleCounter::Now();
+            loss.runWorker();
+            fillTotal += CycleCounter::Elapsed(start);
+        }
+
+        uint64_t tableTotal = 0, directTotal = 0;
+        float worstExcessDb = 0.0f;
+        int numDesigns = 0;
+        for (float speed : speeds)
+        {
+            for (int i = 0; i < numPots - 1; ++i)
+            {
+                // Between the table's loss points
+                const float p = ((float)i + 0.5f) / (float)(numPots - 1);
+                float spacing, thickness, gap;
+                LossFilter::lossKnob(p, spacing, thickness, gap);
+                loss.prepare(sampleRate, LossFilterMode::IIR);
+                direct.prepare(sampleRate, LossFilterMode::IIR);
+
+                uint32_t start = CycleCounter::Now();
+                loss.prepareParams(speed, spacing, thickness, gap, LossFilterMode::IIR);
+                tableTotal += CycleCounter::Elapsed(start);
+                start = CycleCounter::Now();
+                direct.prepareParams(speed, spacing, thickness, gap, LossFilterMode::IIR);
+                directTotal += CycleCounter::Elapsed(start);
+                ++numDesigns;
+
+                float maxDb, rmsDb, tablePassDb, directPassDb;
+                loss.getIirFitError(maxDb, rmsDb, tablePassDb);
+                direct.getIirFitError(maxDb, rmsDb, directPassDb);
+                worstExcessDb = std::max(worstExcessDb, tablePassDb - directPassDb);
+            }
+        }
+        loss.setIirTable(nullptr);
+
+        DaisySeed::PrintLine("Loss IIR table: fill %u %s per entry (%d entries), redesign %u %s (direct fit %u %s), passband error +%u mdB at worst",
+                             (unsigned)(fillTotal / (LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES)), CycleCounter::Unit(),
+                             LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES,
+                             (unsigned)(tableTotal / numDesigns), CycleCounter::Unit(),
+                             (unsigned)(directTotal / numDesigns), CycleCounter::Unit(),
+                             (unsigned)(worstExcessDb * 1000.0f));
+        benchCheck(worstExcessDb <= lossTableExcessDB, "loss IIR table vs direct fit");
+    }
+
+    // Impulse then silence through the recursive part of the chain. Every filter state
+    // decays towards zero and, unguarded, ends up in the subnormal range where each
+    // operation can cost many times a normal one. Cost per window of
+    // decayWindowSamples is printed with and without ScopedFlushToZero.
+    void benchDecayTail(float sampleRate)
+    {
+        static InputFilters filters;
+        static CompressionProcessor comp;
+        static HysteresisProcessor hyst;
+        static DegradeProcessor deg;
+        static LossFilter loss;
+        constexpr int decayWindowSamples = 4800;    // 100 ms
+        constexpr int decayNumWindows = 20;
+        constexpr float decayCostMargin = 1.25f;    // Timing noise, not subnormal stalls (~1.6x and up)
+        constexpr int blocksPerWindow = decayWindowSamples / benchBlockSize;
+        static const char* names[2] = { "FTZ off", "FTZ on" };
+
+        for (int ftz = 0; ftz < 2; ++ftz)
+        {
+            ScopedFlushToZero flush(ftz != 0);
+
+            filters.prepare(sampleRate, 2);
+            filters.prepareParams(100.0f, 10000.0f, true, false);
+            filters.applyParams();
+            comp.prepare(sampleRate);
+            comp.prepareParams(0.5f, 5.0f, 100.0f, true);
+            comp.applyParams();
+            hyst.prepare(sampleRate);
+            hyst.prepareParams(0.5f, 0.5f, 0.5f, true);
+            hyst.applyParams();
+            deg.prepare(sampleRate);
+            deg.prepareParams(0.5f, 0.5f, 0.0f, 0.5f, true);
+            deg.applyParams();
+            loss.prepare(sampleRate);
+
+            auto chain = [](float* l, float* r, int n) {
+                filters.processBlock(l, r, n);
+                comp.processBlock(l, r, n);
+                hyst.processBlock(l, r, n);
+                deg.processBlock(l, r, n);
+                loss.processBlock(l, r, l, r, n);
+            };
+            const uint32_t steady = measurePerSample(sampleRate, chain);
+
+            uint32_t worst = 0, last = 0, lateBest = UINT32_MAX;
+            int subnormals = 0;
+            for (int w = 0; w < decayNumWindows; ++w)
+            {
+                uint32_t total = 0;
+                for (int b = 0; b < blocksPerWindow; ++b)
+                {
+                    std::memset(benchL, 0, sizeof(benchL));
+                    std::memset(benchR, 0, sizeof(benchR));
+                    if (w == 0 && b == 0)
+                        benchL[0] = benchR[0] = 1.0f;
+
+                    const uint32_t start = CycleCounter::Now();
+                    chain(benchL, benchR, benchBlockSize);
+                    total += CycleCounter::Elapsed(start);
+
+                    for (int i = 0; i < benchBlockSize; ++i)
+                        subnormals += (std::fpclassify(benchL[i]) == FP_SUBNORMAL)
+                                    + (std::fpclassify(benchR[i]) == FP_SUBNORMAL);
+                }
+                last = total / (uint32_t)decayWindowSamples;
+                if (last > worst) worst = last;
+                if (w >= decayNumWindows / 2 && last < lateBest) lateBest = last;
+            }
+            DaisySeed::PrintLine("Decay tail %s: sine %u, worst window %u, quietest late window %u, after %d ms %u %s/sample, %d subnormal output(s)",
+                                 names[ftz], (unsigned)steady, (unsigned)worst, (unsigned)lateBest,
+                                 decayNumWindows * decayWindowSamples * 1000 / (int)sampleRate,
+                                 (unsigned)last, CycleCounter::Unit(), subnormals);
+            // Subnormals mostly stay in filter and solver states, where they only show as
+            // cost. Unflushed, every window of the second second is slow; the quietest
+            // of them is the one an interrupted window (host) can't inflate
+            if (ftz != 0)
+            {
+                benchCheck(subnormals == 0, "decay tail produced subnormal outputs with FTZ on");
+                benchCheck((float)lateBest <= decayCostMargin * (float)steady,
+                           "decay tail costs more than the steady state with FTZ on");
+            }
+        }
+    }
+
+    // Worst-case callback: every control tick changes every parameter. The main-thread
+    // side (prepareParams/runWorker) is untimed, the interrupt side (applyParams +
+    // processBlock at the firmware block size) is timed per block.
+    void benchParamUpdates(float sampleRate)
+    {
+        static HysteresisProcessor hyst;
+        static CompressionProcessor comp;
+        static DegradeProcessor deg;
+        constexpr int callbackSize = 4;
+        constexpr int callbacksPerTick = 120;   // ~100 Hz control loop at 48 kHz
+        constexpr int numCallbacks = benchNumBlocks * benchBlockSize / callbackSize;
+
+        hyst.prepare(sampleRate);
+        comp.prepare(sampleRate);
+        deg.prepare(sampleRate);
+
+        uint32_t total = 0, worst = 0;
+        for (int cb = 0; cb < numCallbacks; ++cb)
+        {
+            if (cb % callbacksPerTick == 0)
+            {
+                const float v = (float)((cb / callbacksPerTick) % 10) * 0.1f;
+                hyst.prepareParams(v, 1.0f - v, v, true);
+                comp.prepareParams(v, 1.0f + 20.0f * v, 50.0f + 200.0f * v, true);
+                deg.prepareParams(v, 1.0f - v, v, v, true);
+            }
+            hyst.runWorker();
+            comp.runWorker();
+            deg.runWorker();
+
+            if (cb % (benchBlockSize / callbackSize) == 0)
+                fillSine(cb * callbackSize / benchBlockSize, sampleRate);
+            float* l = benchL + (cb * callbackSize) % benchBlockSize;
+            float* r = benchR + (cb * callbackSize) % benchBlockSize;
+
+            const uint32_t start = CycleCounter::Now();
+            hyst.applyParams();
+            comp.applyParams();
+            deg.applyParams();
+            comp.processBlock(l, r, callbackSize);
+            hyst.processBlock(l, r, callbackSize);
+            deg.processBlock(l, r, callbackSize);
+            const uint32_t elapsed = CycleCounter::Elapsed(start);
+
+            total += elapsed;
+            if (elapsed > worst) worst = elapsed;
+        }
+        DaisySeed::PrintLine("Param updates (comp+hyst+degrade, block %d): avg %u, max %u %s/block",
+                             callbackSize, (unsigned)(total / numCallbacks), (unsigned)worst,
+                             CycleCounter::Unit());
+    }
+
+    // Power of `x` at frequency `hz` (Goertzel, Hann window)
+    float tonePower(const float* x, int n, float hz, float sampleRate)
+    {
+        const float coeff = 2.0f * std::cos(2.0f * (float)M_PI * hz / sampleRate);
+        float s1 = 0.0f, s2 = 0.0f;
+        for (int i = 0; i < n; ++i)
+        {
+            const float w = 0.5f - 0.5f * std::cos(2.0f * (float)M_PI * (float)i / (float)(n - 1));
+            const float s0 = x[i] * w + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        return s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    }
+
+    // ADAA saturator against the bare table curve: cost, and the aliases a 4.7 kHz
+    // sine at full drive folds back below Nyquist (odd harmonics 7..21, relative to
+    // the fundamental). The in-band 3rd harmonic is printed to show the
+    // saturation itself is kept.
+    void benchSaturator(float sampleRate)
+    {
+        static SaturatorProcessor sat;
+        constexpr int numSamples = benchNumBlocks * benchBlockSize;
+        static float adaa[numSamples], naive[numSamples];
+        const float f0 = 4700.0f;
+
+        sat.prepare(sampleRate);
+        sat.prepareParams(1.0f, true);
+        sat.applyParams();
+        const float gIn = std::pow(10.0f, SAT_MAX_DRIVE_DB / 20.0f);
+
+        const uint32_t naiveCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            for (int i = 0; i < n; ++i)
+            {
+                l[i] = sat.curve(l[i] * 16.0f);
+                r[i] = sat.curve(r[i] * 16.0f);
+            }
+        });
+        const uint32_t adaaCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+            sat.processBlock(l, r, n);
+        });
+
+        sat.prepare(sampleRate);
+        for (int b = 0; b < benchNumBlocks; ++b)
+        {
+            for (int i = 0; i < benchBlockSize; ++i)
+            {
+                const int n = b * benchBlockSize + i;
+                benchL[i] = benchR[i] = 0.5f * std::sin(2.0f * (float)M_PI * f0 * (float)n / sampleRate);
+                naive[n] = sat.curve(benchL[i] * gIn);
+            }
+            sat.processBlock(benchL, benchR, benchBlockSize);
+            std::memcpy(adaa + b * benchBlockSize, benchL, sizeof(benchL));
+        }
+
+        float naiveAlias = 0.0f, adaaAlias = 0.0f;
+        for (int k = 7; k <= 21; k += 2)
+        {
+            float hz = std::fmod(f0 * (float)k, sampleRate);
+            if (hz > 0.5f * sampleRate) hz = sampleRate - hz;
+            naiveAlias += tonePower(naive, numSamples, hz, sampleRate);
+            adaaAlias += tonePower(adaa, numSamples, hz, sampleRate);
+        }
+        const float naiveFund = tonePower(naive, numSamples, f0, sampleRate);
+        const float adaaFund = tonePower(adaa, numSamples, f0, sampleRate);
+        const float naiveH3 = tonePower(naive, numSamples, 3.0f * f0, sampleRate);
+        const float adaaH3 = tonePower(adaa, numSamples, 3.0f * f0, sampleRate);
+
+        DaisySeed::PrintLine("Saturator naive: %u %s/sample, aliases %d dB, 3rd harmonic %d dB",
+                             (unsigned)naiveCost, CycleCounter::Unit(),
+                             (int)(10.0f * std::log10(naiveAlias / naiveFund)),
+                             (int)(10.0f * std::log10(naiveH3 / naiveFund)));
+        DaisySeed::PrintLine("Saturator ADAA:  %u %s/sample, aliases %d dB, 3rd harmonic %d dB",
+                             (unsigned)adaaCost, CycleCounter::Unit(),
+                             (int)(10.0f * std::log10(adaaAlias / adaaFund)),
+                             (int)(10.0f * std::log10(adaaH3 / adaaFund)));
+    }
+
+    // Chew / dropout: idle (enabled, depth 0) and busy (depth 1, most frequent events,
+    // about half the time in a burst or dip). The worker draws events between blocks,
+    // outside the measurement. Worst block is a burst or dip ramping.
+    template <typename Stage>
+    void benchRandomStage(const char* name, Stage& stage, float sampleRate)
+    {
+        constexpr int numBlocks = 2000;     // ~2 s, a few dozen events when busy
+
+        for (int busy = 0; busy < 2; ++busy)
+        {
+            stage.prepare(sampleRate);
+            stage.prepareParams(busy ? 1.0f : 0.0f, 1.0f, 0.5f, true);
+            stage.applyParams();
+
+            uint32_t total = 0, worst = 0;
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                fillSine(b, sampleRate);
+                stage.runWorker();
+                const uint32_t start = CycleCounter::Now();
+                stage.processBlock(benchL, benchR, benchBlockSize);
+                const uint32_t cost = CycleCounter::Elapsed(start);
+                total += cost;
+                if (cost > worst) worst = cost;
+            }
+            DaisySeed::PrintLine("%s %s: avg %u, worst block %u %s/sample", name, busy ? "busy" : "idle",
+                                 (unsigned)(total / (uint32_t)(numBlocks * benchBlockSize)),
+                                 (unsigned)(worst / (uint32_t)benchBlockSize), CycleCounter::Unit());
+        }
+    }
+
+    void benchChewDropout(float sampleRate)
+    {
+        static ChewProcessor chew;
+        static DropoutProcessor dropout;
+        benchRandomStage("Chew", chew, sampleRate);
+        benchRandomStage("Dropout", dropout, sampleRate);
+    }
+
+    // StageChain fused (one loop over all per-sample stages) against the same chain
+    // run as a pass per stage, at the firmware block size and at the bench block size.
+    // The two forms must agree within chainTolerance.
+    template <typename Chain>
+    void benchChainForms(const char* name, Chain& chain, float sampleRate,
+                         void (*reset)(float))
+    {
+        static float refL[benchBlockSize], refR[benchBlockSize];
+        static const int callbackSizes[] = { 4, benchBlockSize };
+        static Chain* current;
+        current = &chain;
+
+        for (int size : callbackSizes)
+        {
+            static int callbackSize;
+            callbackSize = size;
+            reset(sampleRate);
+            const uint32_t stagedCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                for (int i = 0; i < n; i += callbackSize)
+                    current->processStaged(l + i, r + i, callbackSize);
+            });
+            reset(sampleRate);
+            const uint32_t fusedCost = measurePerSample(sampleRate, [](float* l, float* r, int n) {
+                for (int i = 0; i < n; i += callbackSize)
+                    current->processBlock(l + i, r + i, callbackSize);
+            });
+            DaisySeed::PrintLine("Chain %s, block %d: staged %u, fused %u %s/sample",
+                                 name, size, (unsigned)stagedCost, (unsigned)fusedCost, CycleCounter::Unit());
+        }
+
+        // Same input through both forms from the same state, one after the other
+        float maxDiff = 0.0f;
+        reset(sampleRate);
+        for (int b = 0; b < benchNumBlocks / 2; ++b)
+        {
+            fillSine(b, sampleRate);
+            chain.processStaged(benchL, benchR, benchBlockSize);
+        }
+        std::memcpy(refL, benchL, sizeof(refL));
+        std::memcpy(refR, benchR, sizeof(refR));
+        reset(sampleRate);
+        for (int b = 0; b < benchNumBlocks / 2; ++b)
+        {
+            fillSine(b, sampleRate);
+            chain.processBlock(benchL, benchR, benchBlockSize);
+        }
+        for (int n = 0; n < benchBlockSize; ++n)
+            maxDiff = std::fmax(maxDiff, std::fmax(std::fabs(benchL[n] - refL[n]), std::fabs(benchR[n] - refR[n])));
+        DaisySeed::PrintLine("Chain %s: fused vs staged max diff %d ppb", name, (int)(maxDiff * 1.0e9f));
+        benchCheck(maxDiff <= chainTolerance, "StageChain fused vs staged");
+    }
+
+    void benchStageChain(float sampleRate)
+    {
+        static CompressionProcessor comp;
+        static HysteresisProcessor hyst;
+        static LossFilter loss;
+
+        // Fresh modules with the same settings, so both forms start from one state
+        auto reset = [](float fs) {
+            comp.prepare(fs);
+            comp.prepareParams(0.5f, 5.0f, 100.0f, true);
+            comp.applyParams();
+            hyst.prepare(fs);
+            hyst.prepareParams(0.5f, 0.5f, 0.5f, true, HysteresisSolver::RK2);
+            hyst.applyParams();
+            loss.prepare(fs);
+        };
+
+        static StageChain<CompressionStage, HysteresisStage<HysteresisSolver::RK2>> compHyst(
+            CompressionStage{ comp }, HysteresisStage<HysteresisSolver::RK2>{ hyst });
+        static StageChain<CompressionStage, LossStage> compLoss(
+            CompressionStage{ comp }, LossStage{ loss });
+        static StageChain<CompressionStage, HysteresisStage<HysteresisSolver::RK2>, LossStage> compHystLoss(
+            CompressionStage{ comp }, HysteresisStage<HysteresisSolver::RK2>{ hyst }, LossStage{ loss });
+
+        benchChainForms("comp+hyst", compHyst, sampleRate, reset);
+        benchChainForms("comp+loss", compLoss, sampleRate, reset);
+        benchChainForms("comp+hyst+loss", compHystLoss, sampleRate, reset);
+    }
+
+    // Whole audio callback at each quality tier the CPU governor can pick, hysteresis on
+    // NR4 so every tier has something to cap. The crossfades and redesigns a tier
+    // change starts are over before the measurement. Peak load as TapeProcessor
+    // reports it to the governor.
+    void benchQualityTiers(float sampleRate, TapeProcessor& processor, const TapeParams& params)
+    {
+        static float outL[benchBlockSize], outR[benchBlockSize];
+        const uint32_t budgetPerSample = CycleCounter::PerSecond() / (uint32_t)sampleRate;
+        TapeParams p = params;
+        p.hyst_enabled = true;
+        p.hyst_solver = HysteresisSolver::NR4;
+        processor.Init(sampleRate, p);
+
+        for (int t = 0; t < (int)QualityTier::NumTiers; ++t)
+        {
+            processor.setQualityTier((QualityTier)t);
+            for (int b = 0; b * benchBlockSize < 2 * LOSS_FADE_LEN; ++b)
+            {
+                fillSine(b, sampleRate);
+                processor.runControlWorker();
+                processor.processBlock(benchL, benchR, outL, outR, benchBlockSize);
+            }
+
+            processor.takePeakLoad();
+            const uint32_t cost = measurePerSample(sampleRate, [&processor](float* l, float* r, int n) {
+                processor.processBlock(l, r, outL, outR, n);
+            });
+            const float peak = processor.takePeakLoad();
+            DaisySeed::PrintLine("Quality tier %d: %u %s/sample (%u%% of the budget), peak load %u%%",
+                                 t, (unsigned)cost, CycleCounter::Unit(),
+                                 (unsigned)(100u * cost / budgetPerSample), (unsigned)(peak * 100.0f));
+        }
+
+        processor.setQualityTier(QualityTier::Full);
+        processor.Init(sampleRate, params);
+    }
+
+    // Whole audio callback (TapeProcessor::processBlock) at the block sizes the SAI can
+    // run, with the control polls every block and once per DAISYTAPE_CONTROL_INTERVAL.
+    // The control loop restages a parameter every 10 ms, so the polls find real work.
+    // Load is the worst callback against its share of the budget (block / fs).
+    void benchBlockSizes(float sampleRate, TapeProcessor& processor, const TapeParams& params)
+    {
+        static const int blockSizes[] = { 1, 2, 4, 8, 16, 32 };
+        static const int intervals[] = { 0, DAISYTAPE_CONTROL_INTERVAL };
+        constexpr int maxCallbackSize = 32;
+        constexpr int numSamples = benchNumBlocks * benchBlockSize;
+        static float inL[maxCallbackSize], inR[maxCallbackSize];
+        static float outL[maxCallbackSize], outR[maxCallbackSize];
+
+        const int tickSamples = (int)sampleRate / 100;
+        const uint32_t budgetPerSample = CycleCounter::PerSecond() / (uint32_t)sampleRate;
+        TapeParams p = params;
+
+        for (int interval : intervals)
+        {
+            processor.setControlInterval(interval);
+            for (int size : blockSizes)
+            {
+                uint32_t total = 0, worst = 0;
+                for (int s = 0; s < numSamples; s += size)
+                {
+                    if (s % tickSamples < size)
+                    {
+                        p.hyst_drive = (s / tickSamples) % 2 ? 0.6f : 0.5f;
+                        processor.updateParams(p);
+                    }
+                    processor.runControlWorker();
+
+                    for (int n = 0; n < size; ++n)
+                    {
+                        const float t = (float)(s + n) / sampleRate;
+                        inL[n] = 0.5f * std::sin(2.0f * (float)M_PI * 440.0f * t);
+                        inR[n] = 0.5f * std::sin(2.0f * (float)M_PI * 660.0f * t);
+                    }
+
+                    const uint32_t start = CycleCounter::Now();
+                    processor.processBlock(inL, inR, outL, outR, size);
+                    const uint32_t elapsed = CycleCounter::Elapsed(start);
+
+                    total += elapsed;
+                    if (elapsed > worst) worst = elapsed;
+                }
+
+                const uint32_t numCallbacks = (uint32_t)((numSamples + size - 1) / size);
+                DaisySeed::PrintLine("Callback block %d, poll %s: avg %u max %u %s/block, %u %s/sample, peak load %u%%",
+                                     size, interval ? "interval" : "every block",
+                                     (unsigned)(total / numCallbacks), (unsigned)worst, CycleCounter::Unit(),
+                                     (unsigned)(total / (uint32_t)numSamples), CycleCounter::Unit(),
+                                     (unsigned)(100u * worst / (budgetPerSample * (uint32_t)size)));
+            }
+        }
+
+        // Back to the firmware state, with clean delay lines
+        processor.setControlInterval(DAISYTAPE_CONTROL_INTERVAL);
+        processor.Init(sampleRate, params);
+    }
+}
+
+int runBenchmarks(float sampleRate, TapeProcessor& processor, const TapeParams& params)
+{
+    CycleCounter::Init();
+    benchFailures = 0;
+
+    DaisySeed::PrintLine("--- DaisyTape benchmarks (block %d) ---", benchBlockSize);
+    benchHysteresis(sampleRate);
+    benchCompression(sampleRate);
+    benchWowFlutter(sampleRate);
+    benchNoise(sampleRate);
+#if DAISYTAPE_BENCHMARK
+    benchDegrade(sampleRate);
+#endif
+    benchInputFilters(sampleRate);
+    benchAzimuth(sampleRate);
+    benchLinkwitzRileyGlide(sampleRate);
+#if DAISYTAPE_CROSSOVER
+    benchCrossover(sampleRate);
+#endif
+    benchParamUpdates(sampleRate);
+    benchStageChain(sampleRate);
+    benchSaturator(sampleRate);
+    benchChewDropout(sampleRate);
+    benchDecayTail(sampleRate);
+    benchFastMath();
+    benchLossDesign(sampleRate);
+    benchLossIir(sampleRate);
+    benchQualityTiers(sampleRate, processor, params);
+    benchBlockSizes(sampleRate, processor, params);
+    DaisySeed::PrintLine("--- benchmarks done, %d check(s) failed ---", benchFailures);
+    return benchFailures;
+}
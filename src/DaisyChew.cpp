@@ -0,0 +1,136 @@
+#include "DaisyChew.h"
+#include "DaisyMemory.h"
+#include <cmath>
+
+ChewProcessor::ChewProcessor()
+    : events(RandomEventTiming{ CHEW_MAX_GAP_S, CHEW_MIN_GAP_S, CHEW_RAMP_MS, CHEW_HOLD_SAMPLES },
+             0x43686577ULL),
+      lp{ 0.0f, 0.0f }
+{
+    burst = Event{ 0, 0, { 1.0f, 1.0f }, 1.0f };
+}
+
+void ChewProcessor::prepare(float sampleRate)
+{
+    events.prepare(sampleRate);
+
+    mix.reset(events.getRampSamples());
+    mix.setCurrentAndTargetValue(0.0f);
+    lp[0] = lp[1] = 0.0f;
+    burst = Event{ 0, 0, { 1.0f, 1.0f }, 1.0f };
+
+    runWorker();
+}
+
+void ChewProcessor::prepareParams(float depth, float freq, float variance, bool enabled)
+{
+    events.prepareParams(depth, freq, variance, enabled);
+    runWorker();
+}
+
+void ChewProcessor::runWorker()
+{
+    events.runWorker([this](Event& e) { drawBurst(e); });
+}
+
+bool ChewProcessor::applyParams()
+{
+    bool switchedOn;
+    if (!events.applyParams(switchedOn)) return false;
+
+    // Switched on: start from clean tape
+    if (switchedOn)
+        mix.setCurrentAndTargetValue(0.0f);
+    return true;
+}
+
+void ChewProcessor::drawBurst(Event& e)
+{
+    const float fs = events.getSampleRate();
+    const float depth = events.depth();
+    const float variance = events.variance();
+
+    const float seconds = events.vary(CHEW_BURST_S);
+    e.length = (int32_t)std::fmax(seconds * fs, (float)events.getRampSamples());
+
+    const float cutoff = CHEW_MAX_CUTOFF_HZ * std::pow(CHEW_MIN_CUTOFF_HZ / CHEW_MAX_CUTOFF_HZ, depth);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        float fc = cutoff * (1.0f + 0.5f * variance * (events.nextFloat() - 0.5f));
+        fc = std::fmin(fc, 0.45f * fs);
+        e.lpCoef[ch] = 1.0f - std::exp(-2.0f * (float)M_PI * fc / fs);
+    }
+    e.level = std::pow(10.0f, -CHEW_MAX_DIP_DB * depth / 20.0f);
+}
+
+DAISYTAPE_ITCM void ChewProcessor::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    if (!events.isActive())
+        return;
+
+    // Usually one run: the block fits in the current gap or burst
+    int32_t done = 0;
+    while (done < blockSize)
+    {
+        int32_t run;
+        switch (events.advance(blockSize - done, run))
+        {
+            // The gap outlasts the previous fade-out, so the filter can be switched here
+            case RandomEvents<Event>::Edge::Start:
+                burst = events.current();
+                mix.setTargetValue(1.0f);
+                break;
+            case RandomEvents<Event>::Edge::End:
+                mix.setTargetValue(0.0f);
+                break;
+            default:
+                break;
+        }
+        processRun(bufferL + done, bufferR + done, run);
+        done += run;
+    }
+}
+
+DAISYTAPE_ITCM void ChewProcessor::processRun(float* bufferL, float* bufferR, int32_t numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const float aL = burst.lpCoef[0], aR = burst.lpCoef[1];
+    const float k = burst.level;
+    float lpL = lp[0], lpR = lp[1];
+
+    if (!mix.isSmoothing())
+    {
+        const float m = mix.getCurrentValue();
+        if (m == 0.0f)
+        {
+            // Clean tape: untouched. Track the input so a burst starts without a step
+            lp[0] = bufferL[numSamples - 1];
+            lp[1] = bufferR[numSamples - 1];
+            return;
+        }
+
+        for (int32_t n = 0; n < numSamples; ++n)
+        {
+            lpL += aL * (bufferL[n] - lpL);
+            lpR += aR * (bufferR[n] - lpR);
+            bufferL[n] += m * (k * lpL - bufferL[n]);
+            bufferR[n] += m * (k * lpR - bufferR[n]);
+        }
+    }
+    else
+    {
+        for (int32_t n = 0; n < numSamples; ++n)
+        {
+            const float m = mix.getNextValue();
+            lpL += aL * (bufferL[n] - lpL);
+            lpR += aR * (bufferR[n] - lpR);
+            bufferL[n] += m * (k * lpL - bufferL[n]);
+            bufferR[n] += m * (k * lpR - bufferR[n]);
+        }
+    }
+
+    lp[0] = lpL;
+    lp[1] = lpR;
+}
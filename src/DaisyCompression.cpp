@@ -0,0 +1,98 @@
+#include "DaisyCompression.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
+#include <algorithm>
+
+namespace {
+    constexpr float dBPerLog2 = 6.02059991f;   // 20 * log10(2)
+}
+
+CompressionProcessor::CompressionProcessor()
+    : fs(48000.0f),
+      onOff(false),
+      threshLog2(0.0f), kneeLog2(1.0f), slope(0.0f), makeupLog2(0.0f),
+      halfKnee(0.5f), kneeScale(0.0f),
+      req_amount(0.0f), req_attackMs(5.0f), req_releaseMs(100.0f),
+      req_onOff(false), requestDirty(false)
+{
+}
+
+void CompressionProcessor::prepare(float sampleRate)
+{
+    fs = sampleRate;
+    levelDetector.prepare(fs);
+    install(cook());
+}
+
+void CompressionProcessor::prepareParams(float amount, float attackMs, float releaseMs, bool enabled)
+{
+    req_amount    = amount;
+    req_attackMs  = attackMs;
+    req_releaseMs = releaseMs;
+    req_onOff     = enabled;
+    requestDirty  = true;
+
+    runWorker();
+}
+
+void CompressionProcessor::runWorker()
+{
+    if (!requestDirty || !mailbox.canPost()) return;
+    if (mailbox.post(cook()))
+        requestDirty = false;
+}
+
+bool CompressionProcessor::applyParams()
+{
+    CookedParams c;
+    if (!mailbox.fetch(c)) return false;
+    install(c);
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+    return true;
+}
+
+CompressionProcessor::CookedParams CompressionProcessor::cook() const
+{
+    CookedParams c;
+    c.onOff = req_onOff;
+
+    const float amount = std::fmin(std::fmax(req_amount, 0.0f), 1.0f);
+
+    // Amount pulls the threshold down and raises the ratio (1:1 .. 4:1), with a wide soft knee
+    const float threshDB = -24.0f * amount;
+    const float ratio    = 1.0f + 3.0f * amount;
+    const float kneeDB   = 12.0f;
+
+    c.threshLog2 = threshDB / dBPerLog2;
+    c.kneeLog2   = kneeDB / dBPerLog2;
+    c.slope      = 1.0f / ratio - 1.0f;
+
+    // Give back half of the gain reduction a full scale signal would get
+    c.makeupLog2 = 0.5f * c.slope * c.threshLog2;
+
+    const float expFactor = -1000.0f / fs;
+    c.tauAtt = ChowLevelDetector::calcTimeConstant(req_attackMs, expFactor);
+    c.tauRel = ChowLevelDetector::calcTimeConstant(req_releaseMs, expFactor);
+    return c;
+}
+
+void CompressionProcessor::install(const CookedParams& c)
+{
+    onOff      = c.onOff;
+    threshLog2 = c.threshLog2;
+    kneeLog2   = c.kneeLog2;
+    slope      = c.slope;
+    makeupLog2 = c.makeupLog2;
+    halfKnee   = 0.5f * kneeLog2;
+    kneeScale  = slope / (2.0f * kneeLog2);
+    levelDetector.setTimeConstants(c.tauAtt, c.tauRel);
+}
+
+DAISYTAPE_ITCM void CompressionProcessor::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    if (!onOff)
+        return;
+
+    for (int32_t n = 0; n < blockSize; ++n)
+        processSample(bufferL[n], bufferR[n]);
+}
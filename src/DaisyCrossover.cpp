@@ -0,0 +1,182 @@
+#include "DaisyCrossover.h"
+
+#if DAISYTAPE_CROSSOVER
+#include "DaisyMemory.h"
+#include <algorithm>
+#include <cassert>
+
+DAISYTAPE_DTCM float CrossoverEngine::scratch[XOVER_MAX_BANDS][2][SAFE_MAX_BLOCK_SIZE];
+
+namespace {
+    // Default split points for 2, 3 and 4 bands
+    const float defaultCrossoverHz[XOVER_MAX_BANDS - 1] = { 250.0f, 2500.0f, 8000.0f };
+}
+
+CrossoverEngine::CrossoverEngine()
+    : fs(48000.0f), numBands(2),
+      reqNumBands(2), requestDirty(false),
+      maxLatency(0.0f), alignClamped(false)
+{
+    for (int i = 0; i < XOVER_MAX_BANDS - 1; ++i)
+        reqHz[i] = defaultCrossoverHz[i];
+    for (int i = 0; i < XOVER_MAX_BANDS; ++i)
+        bandLatency[i] = 0.0f;
+}
+
+void CrossoverEngine::prepare(float sampleRate)
+{
+    fs = sampleRate;
+
+    for (int i = 0; i < XOVER_MAX_BANDS - 1; ++i)
+        crossovers[i].prepare(fs, 2);
+
+    alignClamped = false;
+    for (int b = 0; b < XOVER_MAX_BANDS; ++b)
+    {
+        bandLatency[b] = 0.0f;
+        for (int ch = 0; ch < 2; ++ch)
+            align[b][ch].Init();
+    }
+
+    // Audio isn't running yet: drop anything in flight and install the request right away
+    applyParams();
+    cookRequest();
+    runWorker();
+    applyParams();
+}
+
+void CrossoverEngine::prepareParams(int newNumBands, const float* crossoverHz)
+{
+    reqNumBands = std::min(std::max(newNumBands, 2), XOVER_MAX_BANDS);
+    for (int i = 0; i < reqNumBands - 1; ++i)
+        reqHz[i] = crossoverHz[i];
+
+    cookRequest();
+    runWorker();
+}
+
+void CrossoverEngine::cookRequest()
+{
+    request.numBands = reqNumBands;
+
+    // Ascending, inside [20 Hz, 0.48 fs]: the tree relies on the order
+    float lastHz = 20.0f;
+    for (int i = 0; i < reqNumBands - 1; ++i)
+    {
+        const float hz = std::min(std::max(reqHz[i], lastHz), fs * 0.48f);
+        request.hz[i] = hz;
+        LinkwitzRileyFilter<float>::calcCoefs(hz, fs, request.g[i], request.h[i]);
+        lastHz = hz;
+    }
+    requestDirty = true;
+}
+
+void CrossoverEngine::runWorker()
+{
+    if (!requestDirty || !mailbox.canPost()) return;
+    if (mailbox.post(request))
+        requestDirty = false;
+}
+
+void CrossoverEngine::applyParams()
+{
+    StagedParams staged;
+    if (!mailbox.fetch(staged)) return;
+
+    // A different tree shape leaves nothing worth keeping in the filter states
+    const bool reshaped = staged.numBands != numBands;
+    numBands = staged.numBands;
+
+    for (int x = 0; x < numBands - 1; ++x)
+    {
+        crossovers[x].setCoefs(staged.hz[x], staged.g[x], staged.h[x]);
+        for (int b = 0; b < x; ++b)
+            allpasses[allpassIndex(b, x)].setCoefs(staged.g[x], staged.h[x]);
+    }
+
+    if (reshaped)
+    {
+        for (auto& f : crossovers) f.reset();
+        for (auto& ap : allpasses) ap.reset();
+    }
+}
+
+DAISYTAPE_ITCM void CrossoverEngine::split(const float* inL, const float* inR, int32_t blockSize)
+{
+    assert(blockSize <= SAFE_MAX_BLOCK_SIZE);
+    const int lastX = numBands - 2;
+
+    for (int32_t n = 0; n < blockSize; ++n)
+    {
+        float rest[2] = { inL[n], inR[n] };
+
+        for (int x = 0; x <= lastX; ++x)
+        {
+            float low[2], high[2];
+            crossovers[x].processSampleStereo(rest, low, high);
+
+            // Band x skipped crossovers x+1 .. lastX: phase-match it to the bands that didn't
+            for (int c = x + 1; c <= lastX; ++c)
+                allpasses[allpassIndex(x, c)].processSampleStereo(low);
+
+            scratch[x][0][n] = low[0];
+            scratch[x][1][n] = low[1];
+            rest[0] = high[0];
+            rest[1] = high[1];
+        }
+
+        scratch[lastX + 1][0][n] = rest[0];
+        scratch[lastX + 1][1][n] = rest[1];
+    }
+
+    for (int x = 0; x <= lastX; ++x)
+        crossovers[x].snapToZero();
+}
+
+void CrossoverEngine::setBandLatency(int band, float latencySamples)
+{
+    bandLatency[band] = std::max(latencySamples, 0.0f);
+}
+
+void CrossoverEngine::updateAlignment()
+{
+    maxLatency = 0.0f;
+    for (int b = 0; b < numBands; ++b)
+        maxLatency = std::max(maxLatency, bandLatency[b]);
+
+    // Read at delay 1 returns the sample just written, hence the +1
+    constexpr float maxDelay = (float)(XOVER_ALIGN_SIZE - 2);
+    for (int b = 0; b < numBands; ++b)
+    {
+        float delay = maxLatency - bandLatency[b] + 1.0f;
+        if (delay > maxDelay)
+        {
+            // Lines too short for this chain: reported, sums misaligned
+            alignClamped = true;
+            delay = maxDelay;
+        }
+        align[b][0].SetDelay(delay);
+        align[b][1].SetDelay(delay);
+    }
+}
+
+DAISYTAPE_ITCM void CrossoverEngine::sum(float* outL, float* outR, int32_t blockSize)
+{
+    updateAlignment();
+
+    for (int32_t n = 0; n < blockSize; ++n)
+    {
+        float accL = 0.0f, accR = 0.0f;
+        for (int b = 0; b < numBands; ++b)
+        {
+            align[b][0].Write(scratch[b][0][n]);
+            align[b][1].Write(scratch[b][1][n]);
+            accL += align[b][0].Read();
+            accR += align[b][1].Read();
+        }
+        outL[n] = accL;
+        outR[n] = accR;
+    }
+}
+
+#endif // DAISYTAPE_CROSSOVER
@@ -1,17 +1,20 @@
 #include "DaisyDegrade.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
 #include <cmath>
 #include <cassert>
 
 DegradeProcessor::DegradeProcessor()
     : fs(48000.0f),
-      onOff(true), usePoint1xFlag(false),
-      p_depth(0.0f), p_amount(0.0f), p_variance(0.0f), p_envelope(0.0f),
-      pending_depth(0.0f), pending_amount(0.0f), pending_variance(0.0f), pending_envelope(0.0f),
-      pending_onOff(true), pending_usePoint1x(false), paramsDirty(false),
+      onOff(true), applyEnvelope(false),
+      req_depth(0.0f), req_amount(0.0f), req_variance(0.0f), req_envelope(0.0f),
+      req_onOff(true), req_usePoint1x(false), liveDirty(false),
+      reqGeneration(0),
       sampleCounter(0)
 {
     paramRng.setSeed(0x12345678abcdefULL);
     gainSmoother.setCurrentAndTargetValue(1.0f);
+    cooked = CookedParams{ 0.0f, { 0.0f, 0.0f }, 1.0f, 1.0f, 1.0f, 0 };
 }
 
 void DegradeProcessor::prepare(float sampleRate)
@@ -29,79 +32,140 @@ void DegradeProcessor::prepare(float sampleRate)
     
     gainSmoother.setCurrentAndTargetValue(1.0f);
 
+    // Audio isn't running yet: cook the first set right away
+    runWorker();
     cookParams();
 }
 
 void DegradeProcessor::prepareParams(float depth, float amount, float variance, float envelope,
                                      bool enabled, bool usePoint1x)
 {
-    pending_depth    = depth;
-    pending_amount   = amount;
-    pending_variance = variance;
-    pending_envelope = envelope;
-    pending_onOff    = enabled;
-    pending_usePoint1x = usePoint1x;
-    __DMB();
-    paramsDirty = true;
+    req_depth      = depth;
+    req_amount     = amount;
+    req_variance   = variance;
+    req_envelope   = envelope;
+    req_onOff      = enabled;
+    req_usePoint1x = usePoint1x;
+    liveDirty      = true;
+    reqGeneration  = reqGeneration + 1;
+
+    runWorker();
 }
 
-void DegradeProcessor::applyParams()
+void DegradeProcessor::runWorker()
 {
-    if (!paramsDirty) return;
-    paramsDirty = false;
-    p_depth        = pending_depth;
-    p_amount       = pending_amount;
-    p_variance     = pending_variance;
-    p_envelope     = pending_envelope;
-    onOff          = pending_onOff;
-    usePoint1xFlag = pending_usePoint1x;
+    if (liveDirty && liveBox.post(LiveParams{ req_onOff, req_envelope > 0.0f }))
+        liveDirty = false;
+
+    // Keep the next cooked set ready: the interrupt takes one every DEG_BLOCK_SIZE samples,
+    // the control loop runs far more often than that. Each set carries the request
+    // generation it was cooked for; the interrupt drops the ones a later request made stale
+    if (cookBox.canPost())
+        cookBox.post(cookNext());
 }
 
-void DegradeProcessor::cookParams()
+bool DegradeProcessor::applyParams()
+{
+    // A set cooked before the latest request would hold the knobs back a whole extra
+    // period (~43 ms at 48 kHz): free the slot so the worker cooks a fresh one
+    const CookedParams* pending = cookBox.peek();
+    if (pending != nullptr && pending->generation != reqGeneration)
+    {
+        CookedParams dropped;
+        cookBox.fetch(dropped);
+    }
+
+    LiveParams live;
+    if (!liveBox.fetch(live)) return false;
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+    onOff         = live.onOff;
+    applyEnvelope = live.applyEnvelope;
+    return true;
+}
+
+DegradeProcessor::CookedParams DegradeProcessor::cookNext()
 {
-    float depthValue = usePoint1xFlag ? p_depth * 0.1f : p_depth;
+    CookedParams c;
+    c.generation = reqGeneration;
 
-    float freqHz = 200.0f * std::pow(20000.0f / 200.0f, 1.0f - p_amount);
+    float depthValue = req_usePoint1x ? req_depth * 0.1f : req_depth;
+
+    float freqHz = 200.0f * DegradeMath::pow(20000.0f / 200.0f, 1.0f - req_amount);
     float gainDB = -24.0f * depthValue;
 
-    float noiseGain = 0.5f * depthValue * p_amount;
-    for (int ch = 0; ch < 2; ++ch)
-        noises[ch].setGain(noiseGain);
+    c.noiseGain = 0.5f * depthValue * req_amount;
 
     for (int ch = 0; ch < 2; ++ch)
     {
         float rv = paramRng.nextFloat() - 0.5f; 
-        float varFreq = p_variance * (freqHz / 0.6f) * rv;
+        float varFreq = req_variance * (freqHz / 0.6f) * rv;
         float finalFreq = freqHz + varFreq;
 
         if (finalFreq > fs * 0.49f) finalFreq = fs * 0.49f;
         if (finalFreq < 20.0f) finalFreq = 20.0f;
 
-        filters[ch].setFreq(finalFreq);
+        c.filterPos[ch] = filters[ch].freqToPos(finalFreq);
     }
 
-    float envSkew = 1.0f - std::pow(p_envelope, 0.8f);
+    float envSkew = 1.0f - (req_envelope > 0.0f ? DegradeMath::pow(req_envelope, 0.8f) : 0.0f);
     float attackMs = 10.0f;
-    float releaseMs = 20.0f * std::pow(5000.0f / 20.0f, envSkew);
-    levelDetector.setParameters(attackMs, releaseMs);
+    float releaseMs = 20.0f * DegradeMath::pow(5000.0f / 20.0f, envSkew);
+    const float expFactor = -1000.0f / fs;
+    c.tauAtt = ChowLevelDetector::calcTimeConstant(attackMs, expFactor);
+    c.tauRel = ChowLevelDetector::calcTimeConstant(releaseMs, expFactor);
 
-    float gainVar = p_variance * 36.0f * (paramRng.nextFloat() - 0.5f);
+    float gainVar = req_variance * 36.0f * (paramRng.nextFloat() - 0.5f);
     float finalGainDB = gainDB + gainVar;
     if (finalGainDB > 3.0f) finalGainDB = 3.0f;
 
+    c.gainTarget = DegradeMath::dbToGain(finalGainDB);
+    return c;
+}
+
+void DegradeProcessor::cookParams()
+{
+    // Take the worker's next set. If it hasn't delivered one, or only one cooked before
+    // the latest request, the previous set is re-applied, which leaves all targets where
+    // they are.
+    CookedParams next;
+    if (cookBox.fetch(next) && next.generation == reqGeneration)
+        cooked = next;
+    Telemetry::note(TELEM_EV_DEGRADE_COOK);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        noises[ch].setGain(cooked.noiseGain);
+        filters[ch].setFreqPosition(cooked.filterPos[ch]);
+    }
+
+    levelDetector.setTimeConstants(cooked.tauAtt, cooked.tauRel);
+
     // --- CRITICAL FIX: Set target for Smoother ---
     // Ramp to the new gain over the NEXT 2048 samples.
     // This guarantees the ramp takes ~42ms, not 1ms.
-    float nextGain = std::pow(10.0f, finalGainDB / 20.0f);
     gainSmoother.setSteps(DEG_BLOCK_SIZE); 
-    gainSmoother.setTargetValue(nextGain);
+    gainSmoother.setTargetValue(cooked.gainTarget);
 }
 
-void DegradeProcessor::processBlock(float* inL, float* inR, int blockSize)
+DAISYTAPE_ITCM void DegradeProcessor::processBlock(float* inL, float* inR, int blockSize)
 {
     if (!onOff)
         return;
 
+    processCooking<&DegradeProcessor::processShortBlock>(inL, inR, blockSize);
+}
+
+template <void (DegradeProcessor::*ShortBlock)(float*, float*, int)>
+void DegradeProcessor::processCooking(float* inL, float* inR, int blockSize)
+{
+    // Common case at small block sizes: the whole block fits before the next cook
+    if (sampleCounter + blockSize < DEG_BLOCK_SIZE)
+    {
+        (this->*ShortBlock)(inL, inR, blockSize);
+        sampleCounter += blockSize;
+        return;
+    }
+
     int processed = 0;
     while (processed < blockSize)
     {
@@ -112,7 +176,7 @@ void DegradeProcessor::processBlock(float* inL, float* inR, int blockSize)
         float* chunkL = inL + processed;
         float* chunkR = inR + processed;
 
-        processShortBlock(chunkL, chunkR, chunk);
+        (this->*ShortBlock)(chunkL, chunkR, chunk);
 
         processed += chunk;
         sampleCounter += chunk;
@@ -125,42 +189,129 @@ void DegradeProcessor::processBlock(float* inL, float* inR, int blockSize)
     }
 }
 
-void DegradeProcessor::processShortBlock(float* chunkL, float* chunkR, int numSamples)
+DAISYTAPE_ITCM void DegradeProcessor::processShortBlock(float* chunkL, float* chunkR, int numSamples)
 {
-    // 1) Level detection
-    levelDetector.process(chunkL, chunkR, levelBuf, numSamples, 2);
+    // Split the chunk where either filter's cutoff glide ends, so each segment
+    // runs with a fixed (branch-free) filter update per channel
+    int start = 0;
+    while (start < numSamples)
+    {
+        const int remL = filters[0].getSmoothingRemaining();
+        const int remR = filters[1].getSmoothingRemaining();
 
-    bool applyEnvelope = (p_envelope > 0.0f);
+        if (remL > 0 && remR > 0)
+        {
+            const int end = std::min(numSamples, start + std::min(remL, remR));
+            processFused<true, true>(chunkL, chunkR, start, end, numSamples, applyEnvelope);
+            start = end;
+        }
+        else if (remL > 0)
+        {
+            const int end = std::min(numSamples, start + remL);
+            processFused<true, false>(chunkL, chunkR, start, end, numSamples, applyEnvelope);
+            start = end;
+        }
+        else if (remR > 0)
+        {
+            const int end = std::min(numSamples, start + remR);
+            processFused<false, true>(chunkL, chunkR, start, end, numSamples, applyEnvelope);
+            start = end;
+        }
+        else
+        {
+            processFused<false, false>(chunkL, chunkR, start, numSamples, numSamples, applyEnvelope);
+            start = numSamples;
+        }
+    }
 
-    // 2) Left noise + filter
-    std::memset(noiseBufL, 0, sizeof(float) * numSamples);
-    noises[0].processBlock(noiseBufL, numSamples);
-    for (int i = 0; i < numSamples; ++i)
+    noises[0].endBlock();
+    noises[1].endBlock();
+}
+
+template <bool SmoothL, bool SmoothR>
+void DegradeProcessor::processFused(float* chunkL, float* chunkR, int start, int end, int numSamples,
+                                    bool applyEnvelope)
+{
+    // Fused single pass: level detection, noise, envelope, filter and output gain
+    // per sample for both channels. Same arithmetic (and output) as running each
+    // step as its own pass over scratch buffers (processShortBlockStaged), without
+    // the extra memory traffic. Only the noise comes in short chunks, from the
+    // multi-lane generators.
+    float noiseL[DegradeNoise::noiseChunk];
+    float noiseR[DegradeNoise::noiseChunk];
+
+    for (int c = start; c < end; c += DegradeNoise::noiseChunk)
     {
-        float n = noiseBufL[i];
-        if (applyEnvelope) n *= levelBuf[i];
-        chunkL[i] += n;
+        const int cEnd = std::min(end, c + DegradeNoise::noiseChunk);
+        noises[0].fillSamples(noiseL, c, cEnd, numSamples);
+        noises[1].fillSamples(noiseR, c, cEnd, numSamples);
+
+        for (int i = c; i < cEnd; ++i)
+        {
+            float l = chunkL[i];
+            float r = chunkR[i];
+
+            // 1) Level detection
+            const float level = levelDetector.processSample(ChowLevelDetector::stereoInput(l, r));
+
+            // 2) Noise (+ envelope). Added to 0 first as the noise buffer used to be, keeps signed zeros identical
+            float nL = 0.0f;
+            nL += noiseL[i - c];
+            float nR = 0.0f;
+            nR += noiseR[i - c];
+            if (applyEnvelope)
+            {
+                nL *= level;
+                nR *= level;
+            }
+
+            // 3) Filter
+            l = SmoothL ? filters[0].processSampleSmoothing(l + nL) : filters[0].processSampleSteady(l + nL);
+            r = SmoothR ? filters[1].processSampleSmoothing(r + nR) : filters[1].processSampleSteady(r + nR);
+
+            // 4) Output Gain (Smoothed)
+            const float g = gainSmoother.getNextValue();
+            chunkL[i] = l * g;
+            chunkR[i] = r * g;
+        }
     }
-    filters[0].process(chunkL, numSamples);
+}
 
-    // 3) Right noise + filter
-    std::memset(noiseBufR, 0, sizeof(float) * numSamples);
-    noises[1].processBlock(noiseBufR, numSamples);
-    for (int i = 0; i < numSamples; ++i)
+#if DAISYTAPE_BENCHMARK
+void DegradeProcessor::processBlockStaged(float* inL, float* inR, int blockSize)
+{
+    if (!onOff)
+        return;
+
+    processCooking<&DegradeProcessor::processShortBlockStaged>(inL, inR, blockSize);
+}
+
+void DegradeProcessor::processShortBlockStaged(float* chunkL, float* chunkR, int numSamples)
+{
+    static float levelBuf[SAFE_MAX_BLOCK_SIZE];
+    static float noiseBuf[SAFE_MAX_BLOCK_SIZE];
+    assert(numSamples <= SAFE_MAX_BLOCK_SIZE);
+
+    levelDetector.process(chunkL, chunkR, levelBuf, numSamples, 2);
+
+    float* chunks[2] = { chunkL, chunkR };
+    for (int ch = 0; ch < 2; ++ch)
     {
-        float n = noiseBufR[i];
-        if (applyEnvelope) n *= levelBuf[i];
-        chunkR[i] += n;
+        std::memset(noiseBuf, 0, sizeof(float) * numSamples);
+        noises[ch].processBlock(noiseBuf, numSamples);
+        if (applyEnvelope)
+            for (int i = 0; i < numSamples; ++i)
+                noiseBuf[i] *= levelBuf[i];
+        for (int i = 0; i < numSamples; ++i)
+            chunks[ch][i] += noiseBuf[i];
+        filters[ch].process(chunks[ch], numSamples);
     }
-    filters[1].process(chunkR, numSamples);
 
-    // 4) Apply Output Gain (Smoothed)
     for (int i = 0; i < numSamples; ++i)
     {
-        // Get next value from the smoother.
-        // This handles the interpolation over 2048 steps automatically.
-        float g = gainSmoother.getNextValue();
+        const float g = gainSmoother.getNextValue();
         chunkL[i] *= g;
         chunkR[i] *= g;
     }
-}
\ No newline at end of file
+}
+#endif
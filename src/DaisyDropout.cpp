@@ -0,0 +1,107 @@
+#include "DaisyDropout.h"
+#include "DaisyMemory.h"
+#include <cmath>
+
+DropoutProcessor::DropoutProcessor()
+    : events(RandomEventTiming{ DROPOUT_MAX_GAP_S, DROPOUT_MIN_GAP_S, DROPOUT_RAMP_MS, DROPOUT_HOLD_SAMPLES },
+             0x44726f70ULL)
+{
+    gain.setCurrentAndTargetValue(1.0f);
+}
+
+void DropoutProcessor::prepare(float sampleRate)
+{
+    events.prepare(sampleRate);
+
+    gain.reset(events.getRampSamples());
+    gain.setCurrentAndTargetValue(1.0f);
+
+    runWorker();
+}
+
+void DropoutProcessor::prepareParams(float depth, float freq, float variance, bool enabled)
+{
+    events.prepareParams(depth, freq, variance, enabled);
+    runWorker();
+}
+
+void DropoutProcessor::runWorker()
+{
+    events.runWorker([this](Event& e) { drawDip(e); });
+}
+
+bool DropoutProcessor::applyParams()
+{
+    bool switchedOn;
+    if (!events.applyParams(switchedOn)) return false;
+
+    // Switched on: start at full level
+    if (switchedOn)
+        gain.setCurrentAndTargetValue(1.0f);
+    return true;
+}
+
+void DropoutProcessor::drawDip(Event& e)
+{
+    const float depth = events.depth();
+    const float variance = events.variance();
+
+    // Length uniform over the lower part of the range, all of it with full variance
+    const float spanMs = (DROPOUT_MAX_LEN_MS - DROPOUT_MIN_LEN_MS) * (0.3f + 0.7f * variance);
+    const float ms = DROPOUT_MIN_LEN_MS + spanMs * events.nextFloat();
+    e.length = (int32_t)std::fmax(ms * 0.001f * events.getSampleRate(), (float)events.getRampSamples());
+
+    // Variance makes some dips shallower
+    const float dB = -DROPOUT_MAX_DB * depth * (1.0f - 0.8f * variance * events.nextFloat());
+    e.gain = std::pow(10.0f, dB / 20.0f);
+}
+
+DAISYTAPE_ITCM void DropoutProcessor::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    if (!events.isActive())
+        return;
+
+    // Usually one run: the block fits in the current gap or dip
+    int32_t done = 0;
+    while (done < blockSize)
+    {
+        int32_t run;
+        switch (events.advance(blockSize - done, run))
+        {
+            case RandomEvents<Event>::Edge::Start:
+                gain.setTargetValue(events.current().gain);
+                break;
+            case RandomEvents<Event>::Edge::End:
+                gain.setTargetValue(1.0f);
+                break;
+            default:
+                break;
+        }
+        processRun(bufferL + done, bufferR + done, run);
+        done += run;
+    }
+}
+
+DAISYTAPE_ITCM void DropoutProcessor::processRun(float* bufferL, float* bufferR, int32_t numSamples)
+{
+    if (gain.isSmoothing())
+    {
+        for (int32_t n = 0; n < numSamples; ++n)
+        {
+            const float g = gain.getNextValue();
+            bufferL[n] *= g;
+            bufferR[n] *= g;
+        }
+        return;
+    }
+
+    // Settled: full level leaves the audio untouched, a dip is a constant gain
+    const float g = gain.getCurrentValue();
+    if (g == 1.0f)
+        return;
+    for (int32_t n = 0; n < numSamples; ++n)
+    {
+        bufferL[n] *= g;
+        bufferR[n] *= g;
+    }
+}
@@ -0,0 +1,93 @@
+#include "DaisyGovernor.h"
+#include <algorithm>
+
+CpuGovernor::CpuGovernor()
+{
+    reset();
+}
+
+void CpuGovernor::reset()
+{
+    tier = QualityTier::Full;
+    automatic = true;
+    changed = false;
+
+    // Startup blocks (first designs and crossfades) don't count
+    settleCalls = GOVERNOR_SETTLE_CALLS;
+    overCalls = 0;
+    underCalls = 0;
+    upCalls = GOVERNOR_UP_CALLS;
+    sinceStepUp = GOVERNOR_BOUNCE_CALLS;
+}
+
+void CpuGovernor::setManualTier(QualityTier newTier)
+{
+    automatic = false;
+    if (newTier != tier)
+    {
+        tier = newTier;
+        changed = true;
+    }
+}
+
+void CpuGovernor::setAutomatic()
+{
+    if (automatic) return;
+    automatic = true;
+    settleCalls = GOVERNOR_SETTLE_CALLS;
+    overCalls = 0;
+    underCalls = 0;
+    upCalls = GOVERNOR_UP_CALLS;
+}
+
+bool CpuGovernor::update(float peakLoad)
+{
+    // A manual change is reported by the next call, like an automatic one
+    if (changed)
+    {
+        changed = false;
+        return true;
+    }
+    if (!automatic)
+        return false;
+
+    // The last step up held: back to the normal wait
+    if (sinceStepUp < GOVERNOR_BOUNCE_CALLS && ++sinceStepUp == GOVERNOR_BOUNCE_CALLS)
+        upCalls = GOVERNOR_UP_CALLS;
+
+    if (settleCalls > 0)
+    {
+        --settleCalls;
+        return false;
+    }
+
+    overCalls  = peakLoad > GOVERNOR_DOWN_LOAD ? overCalls + 1 : 0;
+    underCalls = peakLoad < GOVERNOR_UP_LOAD ? underCalls + 1 : 0;
+
+    const int current = (int)tier;
+    if (overCalls >= GOVERNOR_DOWN_CALLS && current + 1 < (int)QualityTier::NumTiers)
+    {
+        // Undoing a recent step up: the load sits between two tiers, wait longer next time
+        if (sinceStepUp < GOVERNOR_BOUNCE_CALLS)
+            upCalls = std::min(2 * upCalls, GOVERNOR_MAX_UP_CALLS);
+        sinceStepUp = GOVERNOR_BOUNCE_CALLS;
+        changeTier(current + 1);
+        return true;
+    }
+
+    if (underCalls >= upCalls && current > 0)
+    {
+        changeTier(current - 1);
+        sinceStepUp = 0;
+        return true;
+    }
+    return false;
+}
+
+void CpuGovernor::changeTier(int newTier)
+{
+    tier = (QualityTier)newTier;
+    settleCalls = GOVERNOR_SETTLE_CALLS;
+    overCalls = 0;
+    underCalls = 0;
+}
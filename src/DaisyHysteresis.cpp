@@ -0,0 +1,186 @@
+#include "DaisyHysteresis.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
+#include <algorithm>
+
+namespace {
+    // DC blocker cutoff
+    constexpr float dcCutoffHz = 20.0f;
+}
+
+// -------------------------------
+// HysteresisCore
+// -------------------------------
+void HysteresisCore::prepare(float sampleRate)
+{
+    T = 1.0f / sampleRate;
+    Talpha = T / 1.9f;
+    reset();
+}
+
+void HysteresisCore::reset()
+{
+    M_n1 = HystFloat2(0.0f);
+    H_n1 = HystFloat2(0.0f);
+    H_d_n1 = HystFloat2(0.0f);
+}
+
+HysteresisCore::Coefs HysteresisCore::calcCoefs(float drive, float saturation, float width)
+{
+    Coefs co;
+    co.M_s = 0.5f + 1.5f * (1.0f - saturation);
+    co.a = co.M_s / (0.01f + 6.0f * drive);
+    co.c = std::sqrt(1.0f - width) - 0.01f;
+
+    co.nc = 1.0f - co.c;
+    co.oneOverA = 1.0f / co.a;
+    co.M_s_oa = co.M_s * co.oneOverA;
+    co.M_s_oa_talpha = alpha * co.M_s_oa;
+    co.M_s_oa_tc = co.c * co.M_s_oa;
+    co.M_s_oa_tc_talpha = alpha * co.M_s_oa_tc;
+    co.M_s_oaSq_tc_talpha = co.M_s_oa_tc_talpha * co.oneOverA;
+    co.M_s_oaSq_tc_talphaSq = alpha * co.M_s_oaSq_tc_talpha;
+    return co;
+}
+
+void HysteresisCore::setCoefs(const Coefs& co)
+{
+    M_s = co.M_s;
+    a = co.a;
+    c = co.c;
+    nc = co.nc;
+    oneOverA = co.oneOverA;
+    M_s_oa = co.M_s_oa;
+    M_s_oa_talpha = co.M_s_oa_talpha;
+    M_s_oa_tc = co.M_s_oa_tc;
+    M_s_oa_tc_talpha = co.M_s_oa_tc_talpha;
+    M_s_oaSq_tc_talpha = co.M_s_oaSq_tc_talpha;
+    M_s_oaSq_tc_talphaSq = co.M_s_oaSq_tc_talphaSq;
+}
+
+template <HysteresisSolver S>
+void HysteresisCore::processBlock(float* bufferL, float* bufferR, int numSamples)
+{
+    for (int n = 0; n < numSamples; ++n)
+        processSample<S>(bufferL[n], bufferR[n]);
+}
+
+template void HysteresisCore::processBlock<HysteresisSolver::RK2>(float*, float*, int);
+template void HysteresisCore::processBlock<HysteresisSolver::RK4>(float*, float*, int);
+template void HysteresisCore::processBlock<HysteresisSolver::NR4>(float*, float*, int);
+
+// -------------------------------
+// HysteresisProcessor
+// -------------------------------
+HysteresisProcessor::HysteresisProcessor()
+    : fs(48000.0f),
+      onOff(true), solver(HysteresisSolver::RK2), makeup(1.0f),
+      req_drive(0.5f), req_saturation(0.5f), req_bias(0.5f),
+      req_onOff(true), req_solver(HysteresisSolver::RK2), requestDirty(false),
+      dcCoef(0.0f), dcX1{ 0.0f, 0.0f }, dcY1{ 0.0f, 0.0f }
+{
+}
+
+void HysteresisProcessor::prepare(float sampleRate)
+{
+    fs = sampleRate;
+    core.prepare(fs);
+
+    dcCoef = 1.0f - (2.0f * (float)M_PI * dcCutoffHz / fs);
+    for (int ch = 0; ch < 2; ++ch)
+        dcX1[ch] = dcY1[ch] = 0.0f;
+
+    install(cook());
+}
+
+void HysteresisProcessor::prepareParams(float drive, float saturation, float bias, bool enabled,
+                                        HysteresisSolver newSolver)
+{
+    req_drive      = drive;
+    req_saturation = saturation;
+    req_bias       = bias;
+    req_onOff      = enabled;
+    req_solver     = newSolver;
+    requestDirty   = true;
+
+    runWorker();
+}
+
+void HysteresisProcessor::runWorker()
+{
+    if (!requestDirty || !mailbox.canPost()) return;
+    if (mailbox.post(cook()))
+        requestDirty = false;
+}
+
+bool HysteresisProcessor::applyParams()
+{
+    CookedParams c;
+    if (!mailbox.fetch(c)) return false;
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+
+    // Coming back from bypass: don't resume from a stale magnetisation state
+    if (c.onOff && !onOff)
+        core.reset();
+
+    install(c);
+    return true;
+}
+
+HysteresisProcessor::CookedParams HysteresisProcessor::cook() const
+{
+    CookedParams c;
+    c.onOff  = req_onOff;
+    c.solver = req_solver;
+
+    // Bias controls the width of the hysteresis loop (more bias -> narrower loop)
+    const float width = 1.0f - std::fmin(std::fmax(req_bias, 0.0f), 1.0f);
+    const float sat   = std::fmin(std::fmax(req_saturation, 0.0f), 1.0f);
+    const float drive = std::fmin(std::fmax(req_drive, 0.0f), 1.0f);
+
+    c.coefs = HysteresisCore::calcCoefs(drive, sat, width);
+
+    // Same makeup curve as ChowTape: compensates for the saturation level M_s
+    c.makeup = (1.0f + 0.6f * width) / (0.5f + 1.5f * (1.0f - sat));
+    return c;
+}
+
+void HysteresisProcessor::install(const CookedParams& c)
+{
+    onOff  = c.onOff;
+    solver = c.solver;
+    makeup = c.makeup;
+    core.setCoefs(c.coefs);
+}
+
+DAISYTAPE_ITCM void HysteresisProcessor::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    if (!onOff)
+        return;
+
+    switch (solver)
+    {
+        case HysteresisSolver::RK4: core.processBlock<HysteresisSolver::RK4>(bufferL, bufferR, blockSize); break;
+        case HysteresisSolver::NR4: core.processBlock<HysteresisSolver::NR4>(bufferL, bufferR, blockSize); break;
+        case HysteresisSolver::RK2:
+        default:                    core.processBlock<HysteresisSolver::RK2>(bufferL, bufferR, blockSize); break;
+    }
+
+    // Makeup gain + DC blocker
+    float* buffers[2] = { bufferL, bufferR };
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        float x1 = dcX1[ch];
+        float y1 = dcY1[ch];
+        for (int n = 0; n < blockSize; ++n)
+        {
+            const float x = buffers[ch][n] * makeup;
+            const float y = x - x1 + dcCoef * y1;
+            x1 = x;
+            y1 = y;
+            buffers[ch][n] = y;
+        }
+        dcX1[ch] = x1;
+        dcY1[ch] = y1;
+    }
+}
@@ -1,11 +1,13 @@
 #include "DaisyInputFilters.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
 
 InputFilters::InputFilters()
-    : pendingLowCut(20.0f), pendingHighCut(22000.0f),
-      pendingOnOff(false), pendingMakeup(false), paramsDirty(false),
+    : reqLowCut(20.0f), reqHighCut(22000.0f),
+      reqOnOff(false), reqMakeup(false), requestDirty(false),
       onOff(false), makeup(false),
       fs(48000.0f), numChannels(0),
-      lowCutFreq(20.0f), highCutFreq(22000.0f),
+      lowCutFreq(20.0f), highCutFreq(22000.0f), lowBypassHz(0.0f), highBypassHz(0.0f),
       makeupDelay{ nullptr, nullptr }
 {
 }
@@ -22,61 +24,148 @@ void InputFilters::prepare(float sampleRate, int numCh)
     fs          = sampleRate;
     numChannels = std::min(numCh, 2); // Max 2 channels
 
+    // Bypass thresholds. Prewarped LR4: with r = tan(pi f / fs) / tan(pi fc / fs) the
+    // low pass is 1 / (1 + r^4), the high pass r^4 / (1 + r^4); both stay within
+    // INPUT_FILTERS_BYPASS_FLAT_DB of unity while r (or 1 / r) is below rFlat
+    const double rFlat = std::pow(std::pow(10.0, INPUT_FILTERS_BYPASS_FLAT_DB / 20.0) - 1.0, 0.25);
+    const double bandTop = std::min(20000.0, 0.45 * (double)fs);
+    lowBypassHz  = (float)(fs / M_PI * std::atan(std::tan(M_PI * 20.0 / fs) * rFlat));
+    highBypassHz = (float)std::min(fs / M_PI * std::atan(std::tan(M_PI * bandTop / fs) / rFlat), 0.48 * fs);
+
+    // One stereo instance per band: L and R run through the kernel together
+    lowCutFilter.prepare(fs, 2);
+    lowCutFilter.setCutoff(lowCutFreq);
+
+    highCutFilter.prepare(fs, 2);
+    highCutFilter.setCutoff(highCutFreq);
+
     for(int i = 0; i < numChannels; ++i)
     {
-        lowCutFilter[i].prepare(fs, 1); // Only 1 channel per filter instance
-        lowCutFilter[i].setCutoff(lowCutFreq);
-
-        highCutFilter[i].prepare(fs, 1);
-        highCutFilter[i].setCutoff(highCutFreq);
-        
         // Init the SDRAM delay lines via the pointers
         if (makeupDelay[i] != nullptr)
-        {
             makeupDelay[i]->Init();
-            makeupDelay[i]->SetDelay(0.0f);
-        }
     }
+    makeupTap.reset(0.0f);
+
+    lowBypass.init(lowCutFreq <= lowBypassHz);
+    highBypass.init(std::fmin(highCutFreq, fs * 0.48f) >= highBypassHz);
 }
 
-void InputFilters::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+DAISYTAPE_ITCM void InputFilters::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
 {
     assert(blockSize <= SAFE_MAX_BLOCK_SIZE);
     if(!onOff)
         return;
 
-    float* buffers[2] = {bufferL, bufferR};
+    const bool wasFading = lowBypass.isFading() || highBypass.isFading();
+    lowBypass.advance(blockSize);
+    highBypass.advance(blockSize);
+    if (!wasFading && (lowBypass.isFading() || highBypass.isFading()))
+        Telemetry::note(TELEM_EV_FILTER_FADE);
+
+    // Mono: the R lane runs on the L input and produces identical results,
+    // so writing it back to the L buffer is harmless
+    float* right = (numChannels > 1) ? bufferR : bufferL;
+    const bool lowRun  = lowBypass.isRunning();
+    const bool highRun = highBypass.isRunning();
 
-    for(int ch = 0; ch < numChannels; ++ch)
+    if (lowRun && highRun)
+        processStereo<true, true>(bufferL, right, blockSize);
+    else if (lowRun)
+        processStereo<true, false>(bufferL, right, blockSize);
+    else if (highRun)
+        processStereo<false, true>(bufferL, right, blockSize);
+    else
+        processStereo<false, false>(bufferL, right, blockSize);
+}
+
+template <bool LowRun, bool HighRun>
+void InputFilters::processStereo(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    // Both bands and both channels in one pass. A bypassed band passes its input
+    // straight on and sends nothing to the makeup path. While fading, both outputs
+    // of the band are scaled by the same wet gain, so band + makeup stays consistent
+    // through the transition.
+    float lowWet = lowBypass.blockWet();
+    const float lowStep = lowBypass.blockStep();
+    const bool lowMix = !(lowWet == 1.0f && lowStep == 0.0f);
+
+    float highWet = highBypass.blockWet();
+    const float highStep = highBypass.blockStep();
+    const bool highMix = !(highWet == 1.0f && highStep == 0.0f);
+
+    for(int n = 0; n < blockSize; ++n)
     {
-        for(int n = 0; n < blockSize; ++n)
+        const float inputSample[2] = { bufferL[n], bufferR[n] };
+        float highPassSample[2] = { inputSample[0], inputSample[1] };
+        float bandPassSample[2];
+
+        // 1. Low-cut filter (Separates Low-pass (Trash) from High-pass (Mid/High))
+        if (LowRun)
+        {
+            float lowPassSample[2];
+            lowCutFilter.tick();
+            lowCutFilter.processSampleStereo(inputSample,
+                                             lowPassSample,       // low-pass output (The part we're cutting)
+                                             highPassSample);     // high-pass output (The part going forward)
+            if (lowMix)
+            {
+                lowWet += lowStep;
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    highPassSample[ch] = inputSample[ch] + lowWet * (highPassSample[ch] - inputSample[ch]);
+                    lowPassSample[ch] *= lowWet;
+                }
+            }
+            makeupLowBuffer[0][n] = lowPassSample[0];
+            makeupLowBuffer[1][n] = lowPassSample[1];
+        }
+        else
+        {
+            makeupLowBuffer[0][n] = 0.0f;
+            makeupLowBuffer[1][n] = 0.0f;
+        }
+
+        // 2. High-cut filter (Separates High-pass (Trash) from Low-pass (Mid/Low))
+        if (HighRun)
         {
-            float inputSample = buffers[ch][n];
-            float highPassSample = 0.0f;
-            float bandPassSample = 0.0f;
-
-            // 1. Low-cut filter (Separates Low-pass (Trash) from High-pass (Mid/High))
-            lowCutFilter[ch].processSample(0,
-                                           inputSample,
-                                           makeupLowBuffer[ch][n],  // low-pass output (The part we're cutting)
-                                           highPassSample);         // high-pass output (The part going forward)
-
-            // 2. High-cut filter (Separates High-pass (Trash) from Low-pass (Mid/Low))
-            highCutFilter[ch].processSample(0,
-                                            highPassSample,
-                                            bandPassSample,          // low-pass output (Our final clean signal for tape)
-                                            makeupHighBuffer[ch][n]); // high-pass output (The part we're cutting)
-
-            // 3. Write main signal back to buffer (This is the filtered signal going to Hysteresis)
-            buffers[ch][n] = bandPassSample;
+            float cutSample[2];
+            highCutFilter.tick();
+            highCutFilter.processSampleStereo(highPassSample,
+                                              bandPassSample,     // low-pass output (Our final clean signal for tape)
+                                              cutSample);         // high-pass output (The part we're cutting)
+            if (highMix)
+            {
+                highWet += highStep;
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    bandPassSample[ch] = highPassSample[ch] + highWet * (bandPassSample[ch] - highPassSample[ch]);
+                    cutSample[ch] *= highWet;
+                }
+            }
+            makeupHighBuffer[0][n] = cutSample[0];
+            makeupHighBuffer[1][n] = cutSample[1];
+        }
+        else
+        {
+            bandPassSample[0] = highPassSample[0];
+            bandPassSample[1] = highPassSample[1];
+            makeupHighBuffer[0][n] = 0.0f;
+            makeupHighBuffer[1][n] = 0.0f;
         }
 
-        lowCutFilter[ch].snapToZero();
-        highCutFilter[ch].snapToZero();
+        // 3. Write main signal back to buffer (This is the filtered signal going to Hysteresis)
+        bufferL[n] = bandPassSample[0];
+        bufferR[n] = bandPassSample[1];
     }
+
+    if (LowRun)
+        lowCutFilter.snapToZero();
+    if (HighRun)
+        highCutFilter.snapToZero();
 }
 
-void InputFilters::processBlockMakeup(float* bufferL, float* bufferR, int32_t blockSize)
+DAISYTAPE_ITCM void InputFilters::processBlockMakeup(float* bufferL, float* bufferR, int32_t blockSize)
 {
     assert(blockSize <= SAFE_MAX_BLOCK_SIZE);
     
@@ -86,18 +175,21 @@ void InputFilters::processBlockMakeup(float* bufferL, float* bufferR, int32_t bl
 
     float* buffers[2] = {bufferL, bufferR};
 
-    for(int ch = 0; ch < numChannels; ++ch)
+    for(int n = 0; n < blockSize; ++n)
     {
-        if (makeupDelay[ch] == nullptr) continue;
+        // Both channels read the same tap (crossfading after a latency change)
+        makeupTap.tick();
 
-        for(int n = 0; n < blockSize; ++n)
+        for(int ch = 0; ch < numChannels; ++ch)
         {
+            if (makeupDelay[ch] == nullptr) continue;
+
             // 1. Combine the makeup signals from the main processBlock
             float makeupSignal = makeupLowBuffer[ch][n] + makeupHighBuffer[ch][n];
 
             // 2. Write to delay line and read the delayed sample
             makeupDelay[ch]->Write(makeupSignal);
-            float delayedMakeup = makeupDelay[ch]->Read();
+            float delayedMakeup = makeupTap.read(*makeupDelay[ch]);
 
             // 3. Add the delayed makeup back to the main buffer
             buffers[ch][n] += delayedMakeup;
@@ -107,37 +199,75 @@ void InputFilters::processBlockMakeup(float* bufferL, float* bufferR, int32_t bl
 
 void InputFilters::setMakeupDelay(float delaySamples)
 {
-    for(int i = 0; i < numChannels; ++i)
-    {
-        if (makeupDelay[i] != nullptr)
-            makeupDelay[i]->SetDelay(delaySamples);
-    }
+    // The lines stand still while the makeup path is off: nothing to fade
+    if (isMakeupActive())
+        makeupTap.setTarget(delaySamples);
+    else
+        makeupTap.reset(delaySamples);
 }
 
 void InputFilters::prepareParams(float lowCut, float highCut, bool enabled, bool makeupEnabled)
 {
-    pendingLowCut  = lowCut;
-    pendingHighCut = highCut;
-    pendingOnOff   = enabled;
-    pendingMakeup  = makeupEnabled;
-    __DMB();    // Data Memory Barrier: ARM Cortex CPU instruction that forces all pending memory write operations to complete before execution continues
-    paramsDirty = true;
+    reqLowCut    = lowCut;
+    reqHighCut   = highCut;
+    reqOnOff     = enabled;
+    reqMakeup    = makeupEnabled;
+    requestDirty = true;
+
+    runWorker();
 }
 
-void InputFilters::applyParams()
+void InputFilters::runWorker()
 {
-    // Don't apply params unless they all have been prepared (paramsDirty flag is set to true)
-    if (!paramsDirty) return;
-    paramsDirty = false;
+    if (!requestDirty || !mailbox.canPost()) return;
+
+    // tan() and the divide happen here, on the main thread
+    StagedParams staged;
+    staged.onOff       = reqOnOff;
+    staged.makeup      = reqMakeup;
+    staged.lowCutFreq  = reqLowCut;
+    staged.highCutFreq = std::fmin(reqHighCut, fs * 0.48f);
+    staged.lowBypass   = staged.lowCutFreq <= lowBypassHz;
+    staged.highBypass  = staged.highCutFreq >= highBypassHz;
+    LinkwitzRileyFilter<float>::calcCoefs(staged.lowCutFreq, fs, staged.lowG, staged.lowH);
+    LinkwitzRileyFilter<float>::calcCoefs(staged.highCutFreq, fs, staged.highG, staged.highH);
+
+    if (mailbox.post(staged))
+        requestDirty = false;
+}
+
+bool InputFilters::applyParams()
+{
+    // Don't apply params unless a complete set has been posted
+    StagedParams staged;
+    if (!mailbox.fetch(staged)) return false;
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+
+    onOff  = staged.onOff;
+    makeup = staged.makeup;
+
+    // A band coming out of bypass restarts from a clean state and warms up before fading in.
+    // Running bands glide to the new cutoff; idle or restarting ones can just jump.
+    const bool lowRestart  = lowBypass.setBypass(staged.lowBypass);
+    const bool highRestart = highBypass.setBypass(staged.highBypass);
+    const bool lowGlide  = lowBypass.isRunning() && !lowRestart;
+    const bool highGlide = highBypass.isRunning() && !highRestart;
 
-    onOff  = pendingOnOff;
-    makeup = pendingMakeup;
+    lowCutFreq = staged.lowCutFreq;
+    highCutFreq = staged.highCutFreq;
 
-    lowCutFreq = pendingLowCut;
-    for (int i = 0; i < numChannels; ++i)
-        lowCutFilter[i].setCutoff(lowCutFreq);
+    if (lowGlide)
+        lowCutFilter.glideTo(lowCutFreq, staged.lowG, staged.lowH, INPUT_FILTERS_GLIDE_SAMPLES);
+    else
+        lowCutFilter.setCoefs(lowCutFreq, staged.lowG, staged.lowH);
+    if (lowRestart)
+        lowCutFilter.reset();
 
-    highCutFreq = std::fmin(pendingHighCut, fs * 0.48f);
-    for (int i = 0; i < numChannels; ++i)
-        highCutFilter[i].setCutoff(highCutFreq);
+    if (highGlide)
+        highCutFilter.glideTo(highCutFreq, staged.highG, staged.highH, INPUT_FILTERS_GLIDE_SAMPLES);
+    else
+        highCutFilter.setCoefs(highCutFreq, staged.highG, staged.highH);
+    if (highRestart)
+        highCutFilter.reset();
+    return true;
 }
@@ -1,19 +1,115 @@
 #include "DaisyLossFilter.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
+#include "DaisyFastMath.h"
+
+#if DAISYTAPE_FASTMATH_LOSS
+using LossMath = FastMath;
+#else
+using LossMath = StdMath;
+#endif
 
 // Ensure the order is even, otherwise the symmetry logic breaks
 static_assert(LOSS_FIR_ORDER % 2 == 0, "LOSS_FIR_ORDER must be even!");
 
+namespace {
+    // Head loss response (spacing, thickness and gap losses) at one frequency.
+    // Signed: the gap loss lobes alternate
+    inline float lossResponse(float freq, float speed, float spacing, float thickness, float gap)
+    {
+        float waveNumber = 2.0f * M_PI * std::max(freq, 20.0f) / (speed * 0.0254f);
+        float thickTimesK = waveNumber * (thickness * 1.0e-6f);
+        float kGapOverTwo = waveNumber * (gap * 1.0e-6f) / 2.0f;
+
+        float val = LossMath::exp(-waveNumber * (spacing * 1.0e-6f));
+
+        if (std::abs(thickTimesK) > 1e-5f)
+            val *= (1.0f - LossMath::exp(-thickTimesK)) / thickTimesK;
+
+        if (std::abs(kGapOverTwo) > 1e-5f)
+            val *= LossMath::sin(kGapOverTwo) / kGapOverTwo;
+
+        return val;
+    }
+
+    // First-order high shelf, bilinear with the corner prewarped (k = tan(pi fc / fs)):
+    // unity at DC, gainDb at Nyquist, corner at the geometric mean of zero and pole
+    void shelfCoeffs(double k, double gainDb, double& b0, double& b1, double& a1)
+    {
+        const double g = std::pow(10.0, gainDb / 20.0);
+        const double sg = std::sqrt(g);
+        const double a0 = 1.0 + k * sg;
+        b0 = g * (1.0 + k / sg) / a0;
+        b1 = g * (k / sg - 1.0) / a0;
+        a1 = (k * sg - 1.0) / a0;
+    }
+
+    // Shelf magnitude in dB at a frequency given by cos(w)
+    double shelfDb(double k, double gainDb, double cosW)
+    {
+        double b0, b1, a1;
+        shelfCoeffs(k, gainDb, b0, b1, a1);
+        const double num = b0 * b0 + b1 * b1 + 2.0 * b0 * b1 * cosW;
+        const double den = 1.0 + a1 * a1 + 2.0 * a1 * cosW;
+        return 10.0 * std::log10(num / den);
+    }
+
+    // Solves a * x = b in place (Gaussian elimination, partial pivoting), x in b
+    template <int N>
+    void solveLinear(double (&a)[N][N], double (&b)[N])
+    {
+        for (int col = 0; col < N; ++col)
+        {
+            int pivot = col;
+            for (int r = col + 1; r < N; ++r)
+                if (std::fabs(a[r][col]) > std::fabs(a[pivot][col])) pivot = r;
+            for (int c = 0; c < N; ++c) std::swap(a[col][c], a[pivot][c]);
+            std::swap(b[col], b[pivot]);
+
+            for (int r = col + 1; r < N; ++r)
+            {
+                const double f = a[r][col] / a[col][col];
+                for (int c = col; c < N; ++c) a[r][c] -= f * a[col][c];
+                b[r] -= f * b[col];
+            }
+        }
+        for (int r = N - 1; r >= 0; --r)
+        {
+            for (int c = r + 1; c < N; ++c) b[r] -= a[r][c] * b[c];
+            b[r] /= a[r][r];
+        }
+    }
+
+    // 20 Hz .. 20 kHz (or 0.45 fs), log spaced
+    inline double gridFreq(int i, int numPoints, double sampleRate)
+    {
+        const double fMax = std::min(20000.0, 0.45 * sampleRate);
+        return 20.0 * std::pow(fMax / 20.0, (double)i / (double)(numPoints - 1));
+    }
+}
+
 LossFilter::LossFilter()
-    : fs(48000.0f), onOff(true),
-      activeFilterIdx(0), fadeCounter(0), triggerFade(false),
-      stageReady(false),
-      p_speed(-1.0f), p_spacing(-1.0f), p_thickness(-1.0f), p_gap(-1.0f)
+    : fs(48000.0f), onOff(true), zeroLatency(false), iirTable(nullptr),
+      activeFilterIdx(0), fusedIdx(0), fadeCounter(0), triggerFade(false),
+      stageReady(false), stagedMode(LossFilterMode::FIR),
+      p_speed(-1.0f), p_spacing(-1.0f), p_thickness(-1.0f), p_gap(-1.0f),
+      p_mode(LossFilterMode::FIR), requestDirty(false),
+      iirMaxErrorDb(0.0f), iirRmsErrorDb(0.0f), iirPassbandErrorDb(0.0f)
 {
+    slotMode[0] = slotMode[1] = LossFilterMode::FIR;
 }
 
-void LossFilter::prepare(float sampleRate)
+void LossFilter::prepare(float sampleRate, LossFilterMode mode)
 {
     fs = sampleRate;
+    zeroLatency = (mode == LossFilterMode::IIR);
+    if (iirTable != nullptr && iirTable->fs != fs)
+    {
+        // Fits for another rate: refill
+        iirTable->fs = fs;
+        iirTable->filled = 0;
+    }
+
     activeFilterIdx = 0;
     fadeCounter     = 0;
     triggerFade     = false;
@@ -21,33 +117,53 @@ void LossFilter::prepare(float sampleRate)
 
     for (int i = 0; i < 2; i++) {
         firFilters[i].reset();
+        iirFilters[i].reset();
         bumpFilters[i].reset();
+        slotMode[i] = LossFilterMode::FIR;
     }
 
     // Initialize active filter directly — no staging needed during prepare
     p_speed = 15.0f; p_spacing = 0.5f; p_thickness = 0.5f; p_gap = 0.5f;
+    p_mode = mode;
+    requestDirty = false;
     calcFirCoeffs(p_speed, p_spacing, p_thickness, p_gap);
     firFilters[activeFilterIdx].setCoefficients(computedFir);
+    if (mode != LossFilterMode::FIR)
+    {
+        designIir();
+        iirFilters[activeFilterIdx].setCoefficients(computedIir);
+    }
+    slotMode[activeFilterIdx] = mode;
     calcHeadBumpCoeffs(p_speed, p_gap * 1.0e-6f, bumpFilters[activeFilterIdx]);
 }
 
 float LossFilter::getLatencySamples() const
 {
-    // FIR Latency is generally Order / 2
-    return onOff ? (float)LOSS_FIR_ORDER / 2.0f : 0.0f;
+    // FIR Latency is generally Order / 2 (IIRAligned delays to match), the IIR is minimum phase.
+    // Fixed by prepare(): both slots always run at the same latency
+    if (!onOff) return 0.0f;
+    return zeroLatency ? 0.0f : (float)LOSS_FIR_ORDER / 2.0f;
 }
 
 // --- HEAVY MATH (Main thread) ---
-void LossFilter::prepareParams(float speed, float spacing, float thickness, float gap)
+void LossFilter::prepareParams(float speed, float spacing, float thickness, float gap,
+                               LossFilterMode mode)
 {
     if (speed < 0.1f) speed = 0.1f;
     if (gap < 0.1f) gap = 0.1f;
 
+    // Keep the latency prepare() set: the crossfade between two slots runs both at once
+    if (zeroLatency)
+        mode = LossFilterMode::IIR;
+    else if (mode == LossFilterMode::IIR)
+        mode = LossFilterMode::IIRAligned;
+
     // Check if anything changed significantly
     if (std::abs(speed - p_speed) < 0.01f &&
         std::abs(spacing - p_spacing) < 0.01f &&
         std::abs(thickness - p_thickness) < 0.01f &&
-        std::abs(gap - p_gap) < 0.01f)
+        std::abs(gap - p_gap) < 0.01f &&
+        mode == p_mode)
     {
         return;     // If not, return
     }
@@ -56,32 +172,63 @@ void LossFilter::prepareParams(float speed, float spacing, float thickness, floa
     p_spacing = spacing; 
     p_thickness = thickness; 
     p_gap = gap;
+    p_mode = mode;
+    requestDirty = true;
 
+    runWorker();
+}
+
+void LossFilter::runWorker()
+{
     // Don't overwrite staging if a previous stage hasn't been consumed yet,
-    // or if a crossfade is already running.
-    if (stageReady || fadeCounter > 0 || triggerFade) return;
+    // or if a crossfade is already running. Retried from the control loop
+    if (stageReady) return;
+    if (requestDirty)
+    {
+        if (fadeCounter > 0 || triggerFade) return;
+        stage();
+        requestDirty = false;
+        return;
+    }
 
+    // Nothing staged: the staging buffers are free for the next table entry
+    if (iirTable != nullptr && iirTable->filled < LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES)
+        fillIirTable();
+}
+
+void LossFilter::stage()
+{
     // Compute into staging buffers — safe, interrupt never reads these until stageReady is set
-    calcFirCoeffs(speed, spacing, thickness, gap);
-    calcHeadBumpCoeffs(speed, gap * 1.0e-6f, stagedBump);
+    calcFirCoeffs(p_speed, p_spacing, p_thickness, p_gap);
+    if (p_mode != LossFilterMode::FIR)
+    {
+        designIir();
+    }
+    stagedMode = p_mode;
+    calcHeadBumpCoeffs(p_speed, p_gap * 1.0e-6f, stagedBump);
 
     __DMB(); // ensure all stores are visible before the flag
     stageReady = true;
 }
 
 // --- INTERRUPT THREAD ---
-void LossFilter::applyParams()
+bool LossFilter::applyParams()
 {
-    if (!stageReady) return;
+    if (!stageReady) return false;
     stageReady = false;
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
 
     // Determine back buffer index here — safe since we're in interrupt and activeFilterIdx is stable
     int backIdx = 1 - activeFilterIdx;
 
     firFilters[backIdx].setCoefficients(computedFir);
+    if (stagedMode != LossFilterMode::FIR)
+        iirFilters[backIdx].setCoefficients(computedIir);
+    slotMode[backIdx] = stagedMode;
     bumpFilters[backIdx].setCoeffs(stagedBump.b0, stagedBump.b1, stagedBump.b2,
                                    stagedBump.a1, stagedBump.a2);
     triggerFade = true;
+    return true;
 }
 
 void LossFilter::calcHeadBumpCoeffs(float speedIps, float gapMeters, StereoBiquad& filter)
@@ -94,16 +241,16 @@ void LossFilter::calcHeadBumpCoeffs(float speedIps, float gapMeters, StereoBiqua
     double bumpFreq = speed * 0.0254 / (gap * 500.0);
     double gainLinear = std::max(1.5 * (1000.0 - std::abs(bumpFreq - 100.0)) / 1000.0, 1.0);
     
-    // 2. Convert to dB for RBJ formulas
-    double gainDB = 20.0 * std::log10(gainLinear);
     double Q = 2.0;
 
-    // 3. Exact RBJ Peaking EQ Formulas
+    // 2. Exact RBJ Peaking EQ Formulas
+    // A = 10^(gainDB / 40) with gainDB = 20 log10(gainLinear), i.e. sqrt(gainLinear)
     double w0 = 2.0 * M_PI * bumpFreq / sampleRate;
+    // Kept in double: w0 is tiny (a few Hz to ~100 Hz), and the poles sit near z = 1
     double cos_w0 = std::cos(w0);
     double sin_w0 = std::sin(w0);
     double alpha = sin_w0 / (2.0 * Q);
-    double A = std::pow(10.0, gainDB / 40.0);
+    double A = std::sqrt(gainLinear);
 
     double b0r = 1.0 + alpha * A;
     double b1r = -2.0 * cos_w0;
@@ -112,7 +259,7 @@ void LossFilter::calcHeadBumpCoeffs(float speedIps, float gapMeters, StereoBiqua
     double a1r = -2.0 * cos_w0;
     double a2r = 1.0 - alpha / A;
 
-    // 4. Normalize by a0
+    // 3. Normalize by a0
     filter.setCoeffs((float)(b0r / a0r), 
                      (float)(b1r / a0r), 
                      (float)(b2r / a0r), 
@@ -133,30 +280,21 @@ void LossFilter::calcFirCoeffs(float speed, float spacing, float thickness, floa
     for (int k = 0; k < LOSS_FIR_ORDER / 2; k++)
     {
         float freq = (float)k * binWidth;
-        float waveNumber = 2.0f * M_PI * std::max(freq, 20.0f) / (speed * 0.0254f);
-        float thickTimesK = waveNumber * (thickness * 1.0e-6f);
-        float kGapOverTwo = waveNumber * (gap * 1.0e-6f) / 2.0f;
-
-        float val = std::exp(-waveNumber * (spacing * 1.0e-6f));
-
-        if (std::abs(thickTimesK) > 1e-5f)
-            val *= (1.0f - std::exp(-thickTimesK)) / thickTimesK;
-
-        if (std::abs(kGapOverTwo) > 1e-5f)
-            val *= std::sin(kGapOverTwo) / kGapOverTwo;
+        float val = lossResponse(freq, speed, spacing, thickness, gap);
 
         Hcoefs[k] = val;
         Hcoefs[LOSS_FIR_ORDER - k - 1] = val;
     }
 
-    // Inverse DFT
+    // Inverse DFT. cos is periodic in k*n mod N: reducing the index keeps the
+    // angle in [0, 2pi) instead of growing to ~N*pi/2
     for (int n = 0; n < LOSS_FIR_ORDER / 2; n++)
     {
         float sum = 0.0f;
         for (int k = 0; k < LOSS_FIR_ORDER; k++)
         {
-            float angle = 2.0f * M_PI * (float)k * (float)n / (float)LOSS_FIR_ORDER;
-            sum += Hcoefs[k] * std::cos(angle);
+            float angle = 2.0f * M_PI * (float)((k * n) % LOSS_FIR_ORDER) / (float)LOSS_FIR_ORDER;
+            sum += Hcoefs[k] * LossMath::cos(angle);
         }
         float val = sum / (float)LOSS_FIR_ORDER;
 
@@ -166,57 +304,453 @@ void LossFilter::calcFirCoeffs(float speed, float spacing, float thickness, floa
     // Result sits in computedFir[] — caller (prepareParams or prepare) decides what to do with it
 }
 
+double LossFilter::firAmplitude(double cosW) const
+{
+    // Taps symmetric around the centre one: the response is a cosine sum (times the
+    // linear phase term), cos(m w) by recurrence
+    constexpr int centre = LOSS_FIR_ORDER / 2;
+    double amp = computedFir[centre];
+    double cPrev = 1.0, cCur = cosW;
+    for (int m = 1; m < centre; ++m)
+    {
+        amp += 2.0 * computedFir[centre + m] * cCur;
+        const double cNext = 2.0 * cosW * cCur - cPrev;
+        cPrev = cCur;
+        cCur = cNext;
+    }
+    return amp;
+}
+
+void LossFilter::fitIir(double* x, int iterations, bool warmStart)
+{
+    // Cascade of first-order high shelves plus an overall gain, fit to the magnitude
+    // of the FIR just designed from Hcoefs (what the IIR replaces) on a log grid,
+    // clamped at LOSS_IIR_FLOOR_DB. In dB the cascade's response is the sum of the
+    // shelves', so each grid point only needs the shelves' own responses.
+    // Gains and corners (log2 Hz) are both free: Levenberg-Marquardt from a staircase,
+    // the total drop split into equal shelves placed where the target crosses each
+    // step. Smooth roll-offs fit closely; the gap loss nulls and a drop steeper than
+    // the shelves can stack can't be followed
+    constexpr int numShelves = 2 * LOSS_IIR_SECTIONS;
+    constexpr int numParams = LOSS_IIR_PARAMS;
+    constexpr double stepDb = 0.1;          // Finite differences for the Jacobian
+    constexpr double stepOct = 0.01;
+
+    const double sampleRate = (double)fs;
+    const double minOct = std::log2(20.0);
+    const double maxOct = std::log2(0.45 * sampleRate);
+
+    // Full weight down to LOSS_IIR_PASSBAND_DB, tapering to a tenth at the floor
+    double cosW[LOSS_IIR_FIT_POINTS], target[LOSS_IIR_FIT_POINTS], weight[LOSS_IIR_FIT_POINTS];
+    for (int j = 0; j < LOSS_IIR_FIT_POINTS; ++j)
+    {
+        const double f = gridFreq(j, LOSS_IIR_FIT_POINTS, sampleRate);
+        cosW[j] = std::cos(2.0 * M_PI * f / sampleRate);
+        const double mag = std::fabs(firAmplitude(cosW[j]));
+        target[j] = std::max(20.0 * std::log10(std::max(mag, 1.0e-12)), (double)LOSS_IIR_FLOOR_DB);
+        const double t = (target[j] - LOSS_IIR_FLOOR_DB) / (LOSS_IIR_PASSBAND_DB - LOSS_IIR_FLOOR_DB);
+        weight[j] = 0.1 + 0.9 * std::min(t, 1.0);
+    }
+
+    auto cornerK = [sampleRate](double oct) { return std::tan(M_PI * std::exp2(oct) / sampleRate); };
+    auto clampParams = [&](double* x) {
+        for (int i = 0; i < numShelves; ++i)
+        {
+            x[1 + i] = std::min(std::max(x[1 + i], -80.0), 24.0);
+            x[1 + numShelves + i] = std::min(std::max(x[1 + numShelves + i], minOct), maxOct);
+        }
+    };
+    auto cost = [&](const double* x) {
+        double k[numShelves];
+        for (int i = 0; i < numShelves; ++i) k[i] = cornerK(x[1 + numShelves + i]);
+        double sum = 0.0;
+        for (int j = 0; j < LOSS_IIR_FIT_POINTS; ++j)
+        {
+            double model = x[0];
+            for (int i = 0; i < numShelves; ++i) model += shelfDb(k[i], x[1 + i], cosW[j]);
+            sum += weight[j] * (target[j] - model) * (target[j] - model);
+        }
+        return sum;
+    };
+
+    double lowest = target[0];
+    for (int j = 1; j < LOSS_IIR_FIT_POINTS; ++j) lowest = std::min(lowest, target[j]);
+    const double stepDown = (target[0] - lowest) / numShelves;
+
+    if (!warmStart) x[0] = target[0];
+    for (int i = 0; i < numShelves && !warmStart; ++i)
+    {
+        // Nearly flat: shelves an octave apart at 0 dB
+        x[1 + i] = -stepDown;
+        x[1 + numShelves + i] = std::log2((double)LOSS_IIR_LOWEST_SHELF_HZ) + (double)i;
+        if (stepDown < 0.01)
+            continue;
+
+        const double level = target[0] - ((double)i + 0.5) * stepDown;
+        for (int j = 1; j < LOSS_IIR_FIT_POINTS; ++j)
+        {
+            if (target[j] <= level)
+            {
+                x[1 + numShelves + i] = std::log2(gridFreq(j, LOSS_IIR_FIT_POINTS, sampleRate));
+                break;
+            }
+        }
+    }
+    clampParams(x);
+
+    double current = cost(x);
+    double lambda = 1.0e-2;
+
+    for (int iter = 0; iter < iterations; ++iter)
+    {
+        // Normal equations at x
+        double jtj[numParams][numParams] = {};
+        double jtr[numParams] = {};
+        double k[numShelves], kStep[numShelves];
+        for (int i = 0; i < numShelves; ++i)
+        {
+            k[i] = cornerK(x[1 + numShelves + i]);
+            kStep[i] = cornerK(x[1 + numShelves + i] + stepOct);
+        }
+
+        for (int j = 0; j < LOSS_IIR_FIT_POINTS; ++j)
+        {
+            double jac[numParams];
+            double model = x[0];
+            jac[0] = 1.0;
+            for (int i = 0; i < numShelves; ++i)
+            {
+                const double d = shelfDb(k[i], x[1 + i], cosW[j]);
+                model += d;
+                jac[1 + i] = (shelfDb(k[i], x[1 + i] + stepDb, cosW[j]) - d) / stepDb;
+                jac[1 + numShelves + i] = (shelfDb(kStep[i], x[1 + i], cosW[j]) - d) / stepOct;
+            }
+
+            const double resid = target[j] - model;
+            for (int r = 0; r < numParams; ++r)
+            {
+                jtr[r] += weight[j] * jac[r] * resid;
+                for (int c = 0; c < numParams; ++c)
+                    jtj[r][c] += weight[j] * jac[r] * jac[c];
+            }
+        }
+
+        // Damped step; shrink the step until the fit improves
+        bool improved = false;
+        for (int attempt = 0; attempt < 8 && !improved; ++attempt)
+        {
+            double a[numParams][numParams];
+            double step[numParams];
+            for (int r = 0; r < numParams; ++r)
+            {
+                for (int c = 0; c < numParams; ++c) a[r][c] = jtj[r][c];
+                a[r][r] += lambda * (jtj[r][r] + 1.0e-9);
+                step[r] = jtr[r];
+            }
+            solveLinear(a, step);
+
+            double trial[numParams];
+            for (int r = 0; r < numParams; ++r) trial[r] = x[r] + step[r];
+            clampParams(trial);
+
+            const double trialCost = cost(trial);
+            if (trialCost < current)
+            {
+                std::copy(trial, trial + numParams, x);
+                current = trialCost;
+                lambda = std::max(lambda * 0.3, 1.0e-7);
+                improved = true;
+            }
+            else
+            {
+                lambda *= 10.0;
+            }
+        }
+        if (!improved)
+            break;      // Converged (or stuck): keep the best so far
+    }
+
+    // Shelves by corner, so neighbouring table entries interpolate shelf by shelf
+    for (int i = 1; i < numShelves; ++i)
+    {
+        for (int j = i; j > 0 && x[1 + numShelves + j] < x[numShelves + j]; --j)
+        {
+            std::swap(x[1 + numShelves + j], x[numShelves + j]);
+            std::swap(x[1 + j], x[j]);
+        }
+    }
+}
+
+void LossFilter::setIirCoeffs(const double* x)
+{
+    constexpr int numShelves = 2 * LOSS_IIR_SECTIONS;
+    const double sampleRate = (double)fs;
+    auto cornerK = [sampleRate](double oct) { return std::tan(M_PI * std::exp2(oct) / sampleRate); };
+
+    // Shelves in pairs make the biquads, the overall gain goes into the first one
+    for (int s = 0; s < LOSS_IIR_SECTIONS; ++s)
+    {
+        double p0, p1, pa, q0, q1, qa;
+        shelfCoeffs(cornerK(x[1 + numShelves + 2 * s]), x[1 + 2 * s], p0, p1, pa);
+        shelfCoeffs(cornerK(x[1 + numShelves + 2 * s + 1]), x[1 + 2 * s + 1], q0, q1, qa);
+        const double g = (s == 0) ? std::pow(10.0, x[0] / 20.0) : 1.0;
+
+        float* c = computedIir + 5 * s;
+        c[0] = (float)(g * p0 * q0);
+        c[1] = (float)(g * (p0 * q1 + p1 * q0));
+        c[2] = (float)(g * p1 * q1);
+        c[3] = (float)(pa + qa);
+        c[4] = (float)(pa * qa);
+    }
+}
+
+namespace {
+    // Table grid: speeds log spaced, loss knob linear
+    inline float tableSpeed(int i)
+    {
+        return LOSS_TABLE_MIN_IPS * std::pow(LOSS_TABLE_MAX_IPS / LOSS_TABLE_MIN_IPS,
+                                             (float)i / (float)(LOSS_TABLE_SPEEDS - 1));
+    }
+}
+
+void LossFilter::designIir()
+{
+    double x[LOSS_IIR_PARAMS];
+    float cellPassbandDb;
+    const bool fromTable = lookupIirTable(x, cellPassbandDb);
+    if (fromTable)
+        fitIir(x, LOSS_TABLE_REFINE_ITERATIONS, true);
+    else
+        fitIir(x);
+    setIirCoeffs(x);
+    measureIirError(iirMaxErrorDb, iirRmsErrorDb, iirPassbandErrorDb);
+
+    // Corners of the cell fit to differently placed shelves: the interpolated start can
+    // sit far from any of them. Rare, fit from scratch
+    if (fromTable && iirPassbandErrorDb > cellPassbandDb + LOSS_TABLE_REFIT_DB)
+    {
+        fitIir(x);
+        setIirCoeffs(x);
+        measureIirError(iirMaxErrorDb, iirRmsErrorDb, iirPassbandErrorDb);
+    }
+}
+
+void LossFilter::fillIirTable()
+{
+    const int n = iirTable->filled;
+    float spacing, thickness, gap;
+    const float q = (float)(n % LOSS_TABLE_LOSSES) / (float)(LOSS_TABLE_LOSSES - 1);
+    lossKnob(q * q, spacing, thickness, gap);
+    calcFirCoeffs(tableSpeed(n / LOSS_TABLE_LOSSES), spacing, thickness, gap);
+
+    double x[LOSS_IIR_PARAMS];
+    fitIir(x);
+    for (int i = 0; i < LOSS_IIR_PARAMS; ++i)
+        iirTable->params[n][i] = (float)x[i];
+    float maxDb, rmsDb;
+    setIirCoeffs(x);
+    measureIirError(maxDb, rmsDb, iirTable->passbandDb[n]);
+    iirTable->filled = n + 1;
+}
+
+bool LossFilter::lookupIirTable(double* x, float& cellPassbandDb) const
+{
+    if (iirTable == nullptr || iirTable->filled < LOSS_TABLE_SPEEDS * LOSS_TABLE_LOSSES
+            || iirTable->fs != fs)
+        return false;
+
+    // Only settings on the knob curve (knob position from the gap), within the grid's speeds
+    const float loss = (p_gap - 1.0f) / 49.0f;
+    float spacing, thickness, gap;
+    lossKnob(loss, spacing, thickness, gap);
+    if (loss < 0.0f || loss > 1.0f
+            || std::abs(spacing - p_spacing) > 0.01f || std::abs(thickness - p_thickness) > 0.01f
+            || p_speed < LOSS_TABLE_MIN_IPS || p_speed > LOSS_TABLE_MAX_IPS)
+        return false;
+
+    // Bilinear in log speed and loss
+    const float u = std::log2(p_speed / LOSS_TABLE_MIN_IPS) / std::log2(LOSS_TABLE_MAX_IPS / LOSS_TABLE_MIN_IPS)
+                  * (float)(LOSS_TABLE_SPEEDS - 1);
+    const float v = std::sqrt(loss) * (float)(LOSS_TABLE_LOSSES - 1);
+    const int i0 = std::min((int)u, LOSS_TABLE_SPEEDS - 2);
+    const int j0 = std::min((int)v, LOSS_TABLE_LOSSES - 2);
+    const double fu = (double)(u - (float)i0);
+    const double fv = (double)(v - (float)j0);
+
+    const int n00 = i0 * LOSS_TABLE_LOSSES + j0;
+    const int n10 = n00 + LOSS_TABLE_LOSSES;
+    cellPassbandDb = std::max(std::max(iirTable->passbandDb[n00], iirTable->passbandDb[n00 + 1]),
+                              std::max(iirTable->passbandDb[n10], iirTable->passbandDb[n10 + 1]));
+
+    const float* p00 = iirTable->params[n00];
+    const float* p01 = p00 + LOSS_IIR_PARAMS;
+    const float* p10 = iirTable->params[n10];
+    const float* p11 = p10 + LOSS_IIR_PARAMS;
+    for (int i = 0; i < LOSS_IIR_PARAMS; ++i)
+    {
+        const double a = (double)p00[i] + fv * ((double)p01[i] - (double)p00[i]);
+        const double b = (double)p10[i] + fv * ((double)p11[i] - (double)p10[i]);
+        x[i] = a + fu * (b - a);
+    }
+    return true;
+}
+
+void LossFilter::measureIirError(float& maxDb, float& rmsDb, float& passbandDb) const
+{
+    // Both responses as they run: the FIR from its taps, the cascade from its float
+    // coefficients. Denser grid than the fit, so misses between fit points show
+    const double sampleRate = (double)fs;
+    double maxErr = 0.0, maxPassErr = 0.0, sumSq = 0.0;
+
+    for (int j = 0; j < LOSS_IIR_ERROR_POINTS; ++j)
+    {
+        const double w = 2.0 * M_PI * gridFreq(j, LOSS_IIR_ERROR_POINTS, sampleRate) / sampleRate;
+        const double cosW = std::cos(w);
+        const double amp = firAmplitude(cosW);
+
+        // Real and imaginary parts, not the expanded |.|^2: near DC that cancels
+        // down to the float rounding of the coefficients
+        double iirSq = 1.0;
+        const double sinW = std::sin(w);
+        const double cos2W = 2.0 * cosW * cosW - 1.0;
+        const double sin2W = 2.0 * sinW * cosW;
+        for (int s = 0; s < LOSS_IIR_SECTIONS; ++s)
+        {
+            const float* c = computedIir + 5 * s;
+            const double numRe = (double)c[0] + (double)c[1] * cosW + (double)c[2] * cos2W;
+            const double numIm = (double)c[1] * sinW + (double)c[2] * sin2W;
+            const double denRe = 1.0 + (double)c[3] * cosW + (double)c[4] * cos2W;
+            const double denIm = (double)c[3] * sinW + (double)c[4] * sin2W;
+            iirSq *= (numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm);
+        }
+
+        const double firDb = std::max(20.0 * std::log10(std::max(std::fabs(amp), 1.0e-12)), (double)LOSS_IIR_FLOOR_DB);
+        const double iirDb = std::max(10.0 * std::log10(std::max(iirSq, 1.0e-24)), (double)LOSS_IIR_FLOOR_DB);
+        const double err = std::fabs(firDb - iirDb);
+        maxErr = std::max(maxErr, err);
+        if (firDb >= LOSS_IIR_PASSBAND_DB)
+            maxPassErr = std::max(maxPassErr, err);
+        sumSq += err * err;
+    }
+
+    maxDb = (float)maxErr;
+    passbandDb = (float)maxPassErr;
+    rmsDb = (float)std::sqrt(sumSq / LOSS_IIR_ERROR_POINTS);
+}
+
 // --- AUDIO THREAD ---
-void LossFilter::processBlock(float* inL, float* inR, float* outL, float* outR, int32_t blockSize)
+DAISYTAPE_ITCM void LossFilter::processBlock(float* inL, float* inR, float* outL, float* outR, int32_t blockSize)
 {
     if (!onOff) return; 
-    
-    if (triggerFade && fadeCounter == 0) {
-        triggerFade = false;
-        fadeCounter = LOSS_FADE_LEN;
-        
-        // Sync state to avoid clicks
-        int backIdx = (activeFilterIdx == 0) ? 1 : 0;
-        firFilters[backIdx].copyStateFrom(firFilters[activeFilterIdx]);
-        bumpFilters[backIdx].copyStateFrom(bumpFilters[activeFilterIdx]);
-    }
-
-    for (int i = 0; i < blockSize; i++)
-    {
-        float l = inL[i];
-        float r = inR[i];
-        
-        float firL, firR;
-        float finalL, finalR;
-
-        // A. Process ACTIVE filter
-        firFilters[activeFilterIdx].process(l, r, firL, firR);
-        bumpFilters[activeFilterIdx].process(firL, firR, finalL, finalR);
-
-        // B. Handle Crossfade
-        if (fadeCounter > 0)
+
+    // The fade state is shared with the main thread (volatile): read it once per block
+    int activeIdx = activeFilterIdx;
+    int fade = fadeCounter;
+
+    if (fade == 0 && triggerFade) {
+        startFade();
+        fade = LOSS_FADE_LEN;
+    }
+
+    int i = 0;
+    if (fade > 0)
+    {
+        const int backIdx = 1 - activeIdx;
+        const int fadeLen = std::min((int)blockSize, fade);
+
+        for (; i < fadeLen; i++)
         {
-            int backIdx = (activeFilterIdx == 0) ? 1 : 0;
+            float l = inL[i];
+            float r = inR[i];
+
+            float firL, firR, finalL, finalR;
             float backL, backR, backFinalL, backFinalR;
 
-            // Process BACK filter
-            firFilters[backIdx].process(l, r, backL, backR);
+            // Both filters while the crossfade runs (in any mode)
+            processLoss(activeIdx, l, r, firL, firR);
+            bumpFilters[activeIdx].process(firL, firR, finalL, finalR);
+            processLoss(backIdx, l, r, backL, backR);
             bumpFilters[backIdx].process(backL, backR, backFinalL, backFinalR);
 
-            float gOld = (float)fadeCounter / (float)LOSS_FADE_LEN;
+            float gOld = (float)fade / (float)LOSS_FADE_LEN;
             float gNew = 1.0f - gOld;
 
-            finalL = finalL * gOld + backFinalL * gNew;
-            finalR = finalR * gOld + backFinalR * gNew;
+            outL[i] = finalL * gOld + backFinalL * gNew;
+            outR[i] = finalR * gOld + backFinalR * gNew;
 
-            fadeCounter--;
-            
-            if (fadeCounter <= 0) {
-                activeFilterIdx = backIdx; 
-            }
+            fade--;
         }
 
-        outL[i] = finalL;
-        outR[i] = finalR;
+        if (fade == 0)
+            activeIdx = backIdx;
+        activeFilterIdx = activeIdx;
+        fadeCounter = fade;
     }
-}
\ No newline at end of file
+
+    // Settled: active filter only
+    if (slotMode[activeIdx] == LossFilterMode::FIR)
+    {
+        for (; i < blockSize; i++)
+        {
+            float l = inL[i];
+            float r = inR[i];
+
+            float firL, firR;
+            firFilters[activeIdx].process(l, r, firL, firR);
+            bumpFilters[activeIdx].process(firL, firR, outL[i], outR[i]);
+        }
+    }
+    else if (slotMode[activeIdx] == LossFilterMode::IIR)
+    {
+        for (; i < blockSize; i++)
+        {
+            float iirL, iirR;
+            iirFilters[activeIdx].process(inL[i], inR[i], iirL, iirR);
+            bumpFilters[activeIdx].process(iirL, iirR, outL[i], outR[i]);
+        }
+    }
+    else
+    {
+        for (; i < blockSize; i++)
+        {
+            float delayedL, delayedR, iirL, iirR;
+            firFilters[activeIdx].delay(inL[i], inR[i], LOSS_FIR_ORDER / 2, delayedL, delayedR);
+            iirFilters[activeIdx].process(delayedL, delayedR, iirL, iirR);
+            bumpFilters[activeIdx].process(iirL, iirR, outL[i], outR[i]);
+        }
+    }
+}
+
+void LossFilter::startFade()
+{
+    triggerFade = false;
+    fadeCounter = LOSS_FADE_LEN;
+    Telemetry::note(TELEM_EV_LOSS_XFADE);
+
+    // Sync state to avoid clicks. The FIR's input history is kept up to date in FIR
+    // and IIRAligned mode; the cascade's state only carries over to the same mode (IIR
+    // and IIRAligned run it at different delays). Stale state starts from silence
+    // instead (it fades in from zero weight)
+    const int activeIdx = activeFilterIdx;
+    const int backIdx = 1 - activeIdx;
+    if (slotMode[activeIdx] != LossFilterMode::IIR)
+        firFilters[backIdx].copyStateFrom(firFilters[activeIdx]);
+    else
+        firFilters[backIdx].clearState();
+    if (slotMode[backIdx] == slotMode[activeIdx])
+        iirFilters[backIdx].copyStateFrom(iirFilters[activeIdx]);
+    else
+        iirFilters[backIdx].clearState();
+    bumpFilters[backIdx].copyStateFrom(bumpFilters[activeIdx]);
+}
+
+bool LossFilter::beginBlock()
+{
+    if (!onOff) return false;
+
+    if (fadeCounter == 0 && triggerFade)
+        startFade();
+
+    fusedIdx = activeFilterIdx;
+    return fadeCounter == 0;
+}
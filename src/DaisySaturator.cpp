@@ -0,0 +1,140 @@
+#include "DaisySaturator.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
+
+SaturatorProcessor::SaturatorProcessor()
+    : fs(48000.0f),
+      onOff(false),
+      req_drive(0.0f), req_onOff(false), requestDirty(false),
+      x1{ 0.0f, 0.0f }, F1{ 0.0, 0.0 }
+{
+}
+
+void SaturatorProcessor::prepare(float sampleRate)
+{
+    fs = sampleRate;
+    buildTable();
+
+    const int rampSteps = (int)(SAT_RAMP_MS * 0.001f * fs);
+    inputGain.reset(rampSteps);
+    outputGain.reset(rampSteps);
+
+    // Drop anything posted for the old state, start settled on the requested values
+    CookedParams stale;
+    mailbox.fetch(stale);
+    requestDirty = false;
+
+    const CookedParams c = cook();
+    onOff = c.onOff;
+    inputGain.setCurrentAndTargetValue(c.inputGain);
+    outputGain.setCurrentAndTargetValue(c.outputGain);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        x1[ch] = 0.0f;
+        F1[ch] = antiderivative(0.0f);
+    }
+}
+
+void SaturatorProcessor::buildTable()
+{
+    // Double precision: F grows to ~7.3 and carries the whole signal in its differences
+    for (int i = 0; i <= SAT_TABLE_SIZE; ++i)
+    {
+        const double x = (double)i * (double)SAT_TABLE_MAX_X / (double)SAT_TABLE_SIZE;
+        fTable[i] = (float)std::tanh(x);
+        FTable[i] = std::log(std::cosh(x));
+    }
+}
+
+float SaturatorProcessor::getLatencySamples() const
+{
+    // ADAA1 outputs the mean over [x[n-1], x[n]]: centred half a sample back
+    return onOff ? 0.5f : 0.0f;
+}
+
+void SaturatorProcessor::prepareParams(float drive, bool enabled)
+{
+    req_drive    = drive;
+    req_onOff    = enabled;
+    requestDirty = true;
+
+    runWorker();
+}
+
+void SaturatorProcessor::runWorker()
+{
+    if (!requestDirty || !mailbox.canPost()) return;
+    if (mailbox.post(cook()))
+        requestDirty = false;
+}
+
+bool SaturatorProcessor::applyParams()
+{
+    CookedParams c;
+    if (!mailbox.fetch(c)) return false;
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+    install(c);
+    return true;
+}
+
+SaturatorProcessor::CookedParams SaturatorProcessor::cook() const
+{
+    CookedParams c;
+    c.onOff = req_onOff;
+
+    const float drive = std::fmin(std::fmax(req_drive, 0.0f), 1.0f);
+    c.inputGain = std::pow(10.0f, drive * SAT_MAX_DRIVE_DB / 20.0f);
+
+    // Give back half of the drive (in dB): hotter, but not drive times louder
+    c.outputGain = 1.0f / std::sqrt(c.inputGain);
+    return c;
+}
+
+void SaturatorProcessor::install(const CookedParams& c)
+{
+    // Coming out of bypass: restart the ADAA memory from silence
+    if (c.onOff && !onOff)
+    {
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            x1[ch] = 0.0f;
+            F1[ch] = antiderivative(0.0f);
+        }
+        inputGain.setCurrentAndTargetValue(c.inputGain);
+        outputGain.setCurrentAndTargetValue(c.outputGain);
+    }
+    else
+    {
+        inputGain.setTargetValue(c.inputGain);
+        outputGain.setTargetValue(c.outputGain);
+    }
+    onOff = c.onOff;
+}
+
+DAISYTAPE_ITCM void SaturatorProcessor::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    if (!onOff)
+        return;
+
+    if (inputGain.isSmoothing() || outputGain.isSmoothing())
+    {
+        for (int32_t n = 0; n < blockSize; ++n)
+        {
+            const float gIn = inputGain.getNextValue();
+            const float gOut = outputGain.getNextValue();
+            bufferL[n] = processSample(0, bufferL[n] * gIn) * gOut;
+            bufferR[n] = processSample(1, bufferR[n] * gIn) * gOut;
+        }
+        return;
+    }
+
+    // Settled: constant gains for the block
+    const float gIn = inputGain.getCurrentValue();
+    const float gOut = outputGain.getCurrentValue();
+    for (int32_t n = 0; n < blockSize; ++n)
+    {
+        bufferL[n] = processSample(0, bufferL[n] * gIn) * gOut;
+        bufferR[n] = processSample(1, bufferR[n] * gIn) * gOut;
+    }
+}
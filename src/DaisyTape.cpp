@@ -2,11 +2,24 @@
 #include "daisysp.h"
 #include "DaisyInputFilters.h"
 #include "TapeProcessor.h"
+#include "DaisyBenchmark.h"
+#include "DaisyFastMath.h"
+#include "DaisyDenormals.h"
+#include "DaisyMemory.h"
+#include "DaisyControls.h"
+#include "DaisyTelemetry.h"
+#include "DaisyCycleCounter.h"
+#include "DaisyGovernor.h"
 #include <cmath>
 
 using namespace daisy;
 using namespace daisysp;
 
+#if DAISYTAPE_FASTMATH_CONTROLS
+using ControlMath = FastMath;
+#else
+using ControlMath = StdMath;
+#endif
 
 // Allocate makeup buffers in SDRAM
 MakeupDelayLine DSY_SDRAM_BSS makeupDelayL;
@@ -17,14 +30,34 @@ DryDelayLine DSY_SDRAM_BSS dryDelayR;
 
 // Declare global objects
 DaisySeed hw;
-TapeProcessor tapeProcessor;
+TapeProcessor DAISYTAPE_DTCM tapeProcessor;    // All audio-rate state, see DaisyMemory.h
+#if DAISYTAPE_TCM_PLACEMENT
+static_assert(sizeof(TapeProcessor) <= DAISYTAPE_DTCM_BUDGET, "TapeProcessor outgrew its DTCM share (the stack needs the rest)");
+#endif
 TapeParams params;
+LossIirTable lossIirTable;  // Filled by the control loop after startup
 CpuLoadMeter audioLoadMeter;
 CpuLoadMeter mainLoadMeter;
+CpuGovernor governor;       // Quality tier from the audio load (setManualTier() to pin one)
+
+// Potentiometers, by ADC channel
+enum PotChannel
+{
+    POT_DEG_ENV = 0,
+    POT_DEG_VAR,
+    POT_DEG_AMOUNT,
+    POT_DEG_DEPTH,
+    POT_TAPE_SPEED,
+    POT_TAPE_LOSS,
+    POT_HIGHCUT,
+    POT_LOWCUT,
+    NUM_POTS
+};
+PotInput pots[NUM_POTS];
 
 
 // Audio callback function
-void AudioCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size)
+DAISYTAPE_ITCM void AudioCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size)
 {
     audioLoadMeter.OnBlockStart();
 
@@ -43,33 +76,41 @@ void AudioCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, s
 }
 
 
-// Function to read and map potentiometer values to parameters
-void read_map_params() 
-{   
-    // Read ADCs 
-    const float pot_lowcut = hw.adc.GetFloat(7);
-    const float pot_highcut = hw.adc.GetFloat(6);
-    const float pot_tape_loss    = hw.adc.GetFloat(5);
-    const float pot_tape_speed = hw.adc.GetFloat(4);
-    const float pot_deg_depth   = hw.adc.GetFloat(3); 
-    const float pot_deg_amount  = hw.adc.GetFloat(2); 
-    const float pot_deg_var     = hw.adc.GetFloat(1); 
-    const float pot_deg_env     = hw.adc.GetFloat(0); 
+// Function to read and map potentiometer values to parameters.
+// Only pots that moved past their hysteresis are remapped; returns true if any did.
+// `force` maps every pot (startup).
+bool read_map_params(bool force)
+{
+    // Read ADCs
+    uint32_t moved = 0;
+    for (int ch = 0; ch < NUM_POTS; ++ch)
+    {
+        if (pots[ch].process(hw.adc.GetFloat(ch)) || force)
+            moved |= 1u << ch;
+    }
+    if (moved == 0)
+        return false;
 
     // Input filters parameters mapping
-    params.lowCutFreq = 20.0f * powf(2000.0f / 20.0f, pot_lowcut);          // Map Low Cut (20Hz to 2kHz, logarithmic scale)
-    params.highCutFreq = 2000.0f * powf(22000.0f / 2000.0f, pot_highcut);   // Map High Cut (2kHz to 22kHz, logarithmic scale)
+    if (moved & (1u << POT_LOWCUT))
+        params.lowCutFreq = 20.0f * ControlMath::pow(2000.0f / 20.0f, pots[POT_LOWCUT].getValue());          // Map Low Cut (20Hz to 2kHz, logarithmic scale)
+    if (moved & (1u << POT_HIGHCUT))
+        params.highCutFreq = 2000.0f * ControlMath::pow(24000.0f / 2000.0f, pots[POT_HIGHCUT].getValue());  // Map High Cut (2kHz to 24kHz, logarithmic scale; bypassed over the flat top ~2% of travel)
     // Loss filter parameters mapping
-    params.gap = 1.0f + (pot_tape_loss * 49.0f);                                 // Map Gap (1 to 50 microns)
-    params.spacing = 0.1f + (pot_tape_loss * 19.9f);                             // Map Spacing (0.1 to 20 microns)
-    params.thickness = 0.1f + (pot_tape_loss * 49.9f);                           // Map Thickness (0.1 to 50 microns)
-    params.speed = 1.0f + (pot_tape_speed * 49.0f); 
-    params.loss = pot_tape_loss;                                                 // Not needed, just for logging 
+    if (moved & (1u << POT_TAPE_LOSS))
+    {
+        const float pot_tape_loss = pots[POT_TAPE_LOSS].getValue();
+        LossFilter::lossKnob(pot_tape_loss, params.spacing, params.thickness, params.gap);   // Spacing 0.1..20, thickness 0.1..50, gap 1..50 microns
+        params.loss = pot_tape_loss;                                                 // Not needed, just for logging
+    }
+    if (moved & (1u << POT_TAPE_SPEED))
+        params.speed = 1.0f + (pots[POT_TAPE_SPEED].getValue() * 49.0f);
     // Degrade processor parameters mapping
-    params.deg_depth    = pot_deg_depth;
-    params.deg_amount   = pot_deg_amount;
-    params.deg_variance = pot_deg_var;
-    params.deg_envelope = pot_deg_env;
+    params.deg_depth    = pots[POT_DEG_DEPTH].getValue();
+    params.deg_amount   = pots[POT_DEG_AMOUNT].getValue();
+    params.deg_variance = pots[POT_DEG_VAR].getValue();
+    params.deg_envelope = pots[POT_DEG_ENV].getValue();
+    return true;
 }
 
 
@@ -90,6 +131,7 @@ void log_status()
     // hw.PrintLine("Avg Main Load: " FLT_FMT3, FLT_VAR3(mainLoadMeter.GetAvgCpuLoad() * 100.0f));
     hw.PrintLine("Max Main Load: " FLT_FMT3, FLT_VAR3(mainLoadMeter.GetMaxCpuLoad() * 100.0f));
     // hw.PrintLine("Min Main Load: " FLT_FMT3, FLT_VAR3(mainLoadMeter.GetMinCpuLoad() * 100.0f));
+    hw.PrintLine("Quality tier: %d (%s)", (int)governor.getTier(), governor.isAutomatic() ? "auto" : "manual");
     hw.PrintLine("------------");
     // hw.PrintLine("this should come every 0.5 seconds...");
 }
@@ -119,47 +161,104 @@ int main(void)
 
     // Setup TapeProcessor
     tapeProcessor.setDelayLinePointers(&makeupDelayL, &makeupDelayR, &dryDelayL, &dryDelayR);
+    tapeProcessor.setLossIirTable(&lossIirTable);
     params.filtersEnabled = true;
     params.makeupEnabled  = false;
     params.deg_enabled  = true;
     params.usePoint1x = true;
     params.dryWet        = 1.0f;
     params.lowCutFreq    = 20.0f;   
-    params.highCutFreq   = 22000.0f;
+    params.highCutFreq   = 24000.0f;  // Flat within 0.1 dB to 20 kHz: bypassed
     params.gap          = 1.0f;
     params.spacing      = 0.1f;
     params.thickness    = 0.1f;
     params.speed        = 15.0f;
+    params.loss_mode    = LossFilterMode::FIR;   // IIR: zero latency (from Init() on), a fraction of the cost
+    params.az_enabled   = false;   // No pot left for the angle: off on hardware
+    params.az_angle     = 0.0f;
     params.deg_depth    = 0.0f;
     params.deg_amount   = 0.0f;
     params.deg_variance = 0.0f;
     params.deg_envelope = 0.0f;
+    params.chew_enabled  = true;    // Nothing happens at depth 0, costs a counter per block
+    params.chew_depth    = 0.0f;
+    params.chew_freq     = 0.5f;
+    params.chew_variance = 0.5f;
+    params.drop_enabled  = true;
+    params.drop_depth    = 0.0f;
+    params.drop_freq     = 0.5f;
+    params.drop_variance = 0.5f;
+    params.comp_enabled    = false;
+    params.comp_amount     = 0.0f;
+    params.comp_attack     = 5.0f;
+    params.comp_release    = 100.0f;
+    params.wf_enabled       = false;
+    params.wf_wow_rate      = 0.5f;
+    params.wf_wow_depth     = 0.0f;
+    params.wf_flutter_rate  = 8.0f;
+    params.wf_flutter_depth = 0.0f;
+    params.wf_drift         = 0.0f;
+    params.wf_interp        = WowFlutterInterp::Hermite;
+    params.sat_enabled     = false;
+    params.sat_drive       = 0.5f;
+    params.hyst_enabled    = false;   // Off until its M7 load is measured (DAISYTAPE_BENCHMARK build)
+    params.hyst_drive      = 0.5f;
+    params.hyst_saturation = 0.5f;
+    params.hyst_bias       = 0.5f;
+    params.hyst_solver     = HysteresisSolver::RK2;   // Fewest evaluations per sample
     tapeProcessor.Init(sample_rate, params);
 
     // Setup CPU Load Meter
     audioLoadMeter.Init(sample_rate, hw.AudioBlockSize());
     mainLoadMeter.Init(100, 1);
     
+#if !DAISYTAPE_TELEMETRY
     int log_counter = 0;
+#endif
 
     // Start adc, log and audio
     hw.adc.Start();
+    System::Delay(1);       // first conversions
+    for (int ch = 0; ch < NUM_POTS; ++ch)
+        pots[ch].init(hw.adc.GetFloat(ch));
+    read_map_params(true);
+    tapeProcessor.updateParams(params);
     hw.StartLog();
+#if DAISYTAPE_BENCHMARK
+    runBenchmarks(sample_rate, tapeProcessor, params);
+#endif
+    // Audio callback starts with FZ set (processBlock also sets it for its own scope)
+    ScopedFlushToZero::enableForInterrupts();
+    // Per-block cycle counts for the telemetry records
+    CycleCounter::Init();
     hw.StartAudio(AudioCallback);
 
     while(1)
     {   
         mainLoadMeter.OnBlockStart();
 
-        // Read potentiometers and map them to parameters
-        read_map_params();
-        // Update parameters
-        tapeProcessor.updateParams(params);
+        // Read potentiometers, remap and restage only what moved
+        if (read_map_params(false))
+        {
+            tapeProcessor.updateParams(params);
+        }
+        // Quality tier from the worst audio block since the last pass
+        if (governor.update(tapeProcessor.takePeakLoad()))
+        {
+            tapeProcessor.setQualityTier(governor.getTier());
+        }
+        // Compute coefficients off the audio interrupt
+        tapeProcessor.runControlWorker();
+#if DAISYTAPE_TELEMETRY
+        // Per-block records from the audio interrupt, printed as hex batches
+        Telemetry::drain();
+#else
         // Optional log (50 times slower than the controls loop rate)
         if (log_counter++ > 50) {
             log_status();
             log_counter = 0;
         }
+#endif
 
         mainLoadMeter.OnBlockEnd();
 
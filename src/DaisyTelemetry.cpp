@@ -0,0 +1,94 @@
+#include "DaisyTelemetry.h"
+#include "DaisyMemory.h"
+
+namespace {
+    constexpr uint32_t ringMask = TELEMETRY_RING_SIZE - 1;
+    static_assert((TELEMETRY_RING_SIZE & ringMask) == 0, "TELEMETRY_RING_SIZE must be a power of two");
+
+    const char hexDigits[] = "0123456789abcdef";
+
+    // Little-endian bytes of a record as hex, matching the struct layout
+    char* appendHex(char* p, const TelemetryRecord& r)
+    {
+        const uint8_t bytes[8] = {
+            (uint8_t)r.cycles, (uint8_t)(r.cycles >> 8), (uint8_t)(r.cycles >> 16), (uint8_t)(r.cycles >> 24),
+            (uint8_t)r.seq, (uint8_t)(r.seq >> 8), r.events, r.clips
+        };
+        for (uint8_t b : bytes)
+        {
+            *p++ = hexDigits[b >> 4];
+            *p++ = hexDigits[b & 0xF];
+        }
+        return p;
+    }
+}
+
+TelemetryRecord Telemetry::ring[TELEMETRY_RING_SIZE];
+volatile uint32_t Telemetry::head = 0;
+volatile uint32_t Telemetry::tail = 0;
+uint8_t Telemetry::blockEvents = 0;
+uint16_t Telemetry::seq = 0;
+bool Telemetry::overflowed = false;
+
+DAISYTAPE_ITCM void Telemetry::endBlock(uint32_t cycles, uint32_t clips)
+{
+    const uint32_t h = head;
+    const uint16_t blockSeq = seq++;
+    const uint8_t events = blockEvents;
+    blockEvents = 0;
+
+    if (h - tail >= TELEMETRY_RING_SIZE)
+    {
+        overflowed = true;
+        return;
+    }
+
+    TelemetryRecord& r = ring[h & ringMask];
+    r.cycles = cycles;
+    r.seq    = blockSeq;
+    r.events = events | (overflowed ? TELEM_EV_RING_OVERFLOW : 0);
+    r.clips  = (uint8_t)(clips > 255u ? 255u : clips);
+    overflowed = false;
+
+    __DMB();    // the record must land before the index that publishes it
+    head = h + 1;
+}
+
+int Telemetry::pop(TelemetryRecord* out, int maxRecords)
+{
+    const uint32_t t = tail;
+    uint32_t available = head - t;
+    __DMB();    // read the records only after seeing the index
+    if (available > (uint32_t)maxRecords)
+        available = (uint32_t)maxRecords;
+
+    for (uint32_t i = 0; i < available; ++i)
+        out[i] = ring[(t + i) & ringMask];
+
+    __DMB();    // done reading before handing the slots back
+    tail = t + available;
+    return (int)available;
+}
+
+void Telemetry::drain()
+{
+    TelemetryRecord batch[TELEMETRY_RECORDS_PER_LINE];
+    char line[sizeof(TELEMETRY_LINE_TAG) + 1 + TELEMETRY_RECORDS_PER_LINE * 16];
+
+    for (int l = 0; l < TELEMETRY_MAX_LINES_PER_TICK; ++l)
+    {
+        const int n = pop(batch, TELEMETRY_RECORDS_PER_LINE);
+        if (n == 0)
+            return;
+
+        char* p = line;
+        for (const char* tag = TELEMETRY_LINE_TAG; *tag; )
+            *p++ = *tag++;
+        *p++ = ' ';
+        for (int i = 0; i < n; ++i)
+            p = appendHex(p, batch[i]);
+        *p = '\0';
+
+        daisy::DaisySeed::PrintLine("%s", line);
+    }
+}
@@ -0,0 +1,299 @@
+#include "DaisyWowFlutter.h"
+#include "DaisyLatencyTap.h"
+#include "DaisyMemory.h"
+#include "DaisyTelemetry.h"
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace {
+    constexpr uint32_t ringMask = WF_DELAY_SIZE - 1;
+    constexpr float twoPi = 2.0f * (float)M_PI;
+
+    // Drift: new random target every ~0.5 s, followed by a ~0.3 Hz one-pole
+    constexpr float driftTargetPeriodSec = 0.5f;
+    constexpr float driftCutoffHz = 0.3f;
+
+    // Flutter is a capstan-like fundamental plus some 2nd harmonic
+    constexpr float flutterFundamental = 0.8f;
+    constexpr float flutterHarmonic = 0.2f;
+}
+
+WowFlutterProcessor::WowFlutterProcessor()
+    : fs(48000.0f),
+      onOff(false), state(Switch::Off), fillLeft(0), fadeLeft(0), interp(WowFlutterInterp::Hermite),
+      p_wowRate(0.5f), p_wowDepth(0.0f), p_flutterRate(8.0f), p_flutterDepth(0.0f), p_drift(0.0f),
+      pending_wowRate(0.5f), pending_wowDepth(0.0f), pending_flutterRate(8.0f), pending_flutterDepth(0.0f),
+      pending_drift(0.0f), pending_onOff(false), pending_interp(WowFlutterInterp::Hermite), paramsDirty(false),
+      wowPhase(0.0f), flutterPhase(0.0f),
+      driftValue(0.0f), driftTarget(0.0f), driftCoef(0.0f), driftCounter(0),
+      driftRng(0x5eed),
+      baseDelay(0.0f), msToSamples(48.0f), delayPrev(0.0f), delayNext(0.0f), controlCounter(0),
+      writeIdx(0), apState{ 0.0f, 0.0f }
+{
+}
+
+void WowFlutterProcessor::prepare(float sampleRate)
+{
+    assert(sampleRate <= (float)WF_MAX_SAMPLE_RATE);
+
+    fs = sampleRate;
+    msToSamples = fs / 1000.0f;
+
+    // Centre the modulation so the delay never drops below 2 samples
+    baseDelay = wowflutter::maxModDepthMs * msToSamples + 2.0f;
+
+    driftCoef = 1.0f - std::exp(-twoPi * driftCutoffHz * (float)WF_CONTROL_BLOCK / fs);
+
+    wowPhase = flutterPhase = 0.0f;
+    driftValue = driftTarget = 0.0f;
+    driftCounter = 0;
+    controlCounter = 0;
+    delayPrev = delayNext = baseDelay;
+
+    std::memset(ring, 0, sizeof(ring));
+    writeIdx = 0;
+    apState[0] = apState[1] = 0.0f;
+}
+
+void WowFlutterProcessor::prepareParams(float wowRate, float wowDepth, float flutterRate, float flutterDepth,
+                                        float drift, bool enabled, WowFlutterInterp newInterp)
+{
+    pending_wowRate      = wowRate;
+    pending_wowDepth     = wowDepth;
+    pending_flutterRate  = flutterRate;
+    pending_flutterDepth = flutterDepth;
+    pending_drift        = drift;
+    pending_onOff        = enabled;
+    pending_interp       = newInterp;
+    __DMB();
+    paramsDirty = true;
+}
+
+bool WowFlutterProcessor::applyParams()
+{
+    // Ring filled since the last tick: the fade starts here, where TapeProcessor reads
+    // the new latency right after, so the compensation taps start fading with it
+    if (state == Switch::Filling && fillLeft <= 0)
+    {
+        state = Switch::FadingIn;
+        fadeLeft = LATENCY_FADE_SAMPLES;
+    }
+
+    if (!paramsDirty) return false;
+    paramsDirty = false;
+    Telemetry::note(TELEM_EV_PARAMS_APPLIED);
+
+    p_wowRate      = pending_wowRate;
+    p_wowDepth     = std::fmin(std::fmax(pending_wowDepth, 0.0f), 1.0f);
+    p_flutterRate  = pending_flutterRate;
+    p_flutterDepth = std::fmin(std::fmax(pending_flutterDepth, 0.0f), 1.0f);
+    p_drift        = std::fmin(std::fmax(pending_drift, 0.0f), 1.0f);
+    interp         = pending_interp;
+
+    if (pending_onOff)
+    {
+        if (state == Switch::Off)
+        {
+            // The ring isn't written while bypassed: clear it so we don't replay stale
+            // audio, then fill it with the live input before fading the delay in
+            std::memset(ring, 0, sizeof(ring));
+            apState[0] = apState[1] = 0.0f;
+            state = Switch::Filling;
+            // Deepest tap: full wow, flutter and drift on top of baseDelay, plus the
+            // interpolator's neighbours
+            fillLeft = (int)(baseDelay + wowflutter::maxModDepthMs * msToSamples) + 4;
+            onOff = true;
+        }
+        else if (state == Switch::FadingOut)
+        {
+            // Turn around from the current mix
+            state = Switch::FadingIn;
+            fadeLeft = LATENCY_FADE_SAMPLES - fadeLeft;
+        }
+    }
+    else
+    {
+        if (state == Switch::Filling)
+        {
+            // Output was still direct
+            state = Switch::Off;
+            onOff = false;
+        }
+        else if (state == Switch::On || state == Switch::FadingIn)
+        {
+            fadeLeft = state == Switch::On ? LATENCY_FADE_SAMPLES : LATENCY_FADE_SAMPLES - fadeLeft;
+            state = Switch::FadingOut;
+        }
+    }
+    return true;
+}
+
+float WowFlutterProcessor::getLatencySamples() const
+{
+    return (state == Switch::FadingIn || state == Switch::On) ? baseDelay : 0.0f;
+}
+
+float WowFlutterProcessor::calcModulation()
+{
+    const float controlPeriod = (float)WF_CONTROL_BLOCK / fs;
+
+    wowPhase += p_wowRate * controlPeriod;
+    wowPhase -= std::floor(wowPhase);
+    flutterPhase += p_flutterRate * controlPeriod;
+    flutterPhase -= std::floor(flutterPhase);
+
+    if (--driftCounter <= 0)
+    {
+        driftTarget = 2.0f * driftRng.nextFloat() - 1.0f;
+        driftCounter = (int)(driftTargetPeriodSec / controlPeriod);
+    }
+    driftValue += driftCoef * (driftTarget - driftValue);
+
+    const float wow = std::sin(twoPi * wowPhase) * p_wowDepth * WF_WOW_MAX_DEPTH_MS;
+    const float flutter = (flutterFundamental * std::sin(twoPi * flutterPhase)
+                         + flutterHarmonic * std::sin(2.0f * twoPi * flutterPhase))
+                          * p_flutterDepth * WF_FLUTTER_MAX_DEPTH_MS;
+    const float drift = driftValue * p_drift * WF_DRIFT_MAX_DEPTH_MS;
+
+    return baseDelay + (wow + flutter + drift) * msToSamples;
+}
+
+template <WowFlutterInterp I>
+void WowFlutterProcessor::processSegment(float* bufferL, float* bufferR, int numSamples,
+                                         float delayStart, float delayInc)
+{
+    float* buffers[2] = { bufferL, bufferR };
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const float delay = delayStart + delayInc * (float)n;
+        const int32_t di = (int32_t)delay;
+        const float f = delay - (float)di;
+        const uint32_t w = writeIdx;
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            const float* line = ring[ch];
+            ring[ch][w] = buffers[ch][n];
+
+            // x(k) = sample written k samples ago
+            const float x0 = line[(w - di) & ringMask];
+            const float x1 = line[(w - di - 1) & ringMask];
+
+            if (I == WowFlutterInterp::Linear)
+            {
+                buffers[ch][n] = x0 + f * (x1 - x0);
+            }
+            else if (I == WowFlutterInterp::Hermite)
+            {
+                // Same 4-point, 3rd-order Hermite as daisysp::DelayLine::ReadHermite
+                const float xm1 = line[(w - di + 1) & ringMask];
+                const float x2  = line[(w - di - 2) & ringMask];
+                const float c = (x1 - xm1) * 0.5f;
+                const float v = x0 - x1;
+                const float wv = c + v;
+                const float a = wv + v + (x2 - x0) * 0.5f;
+                const float bNeg = wv + a;
+                buffers[ch][n] = (((a * f) - bNeg) * f + c) * f + x0;
+            }
+            else
+            {
+                // First-order allpass interpolator, eta = (1 - f) / (1 + f)
+                const float eta = (1.0f - f) / (1.0f + f);
+                const float y = eta * (x0 - apState[ch]) + x1;
+                apState[ch] = y;
+                buffers[ch][n] = y;
+            }
+        }
+
+        writeIdx = (w + 1) & ringMask;
+    }
+}
+
+DAISYTAPE_ITCM void WowFlutterProcessor::processBlock(float* bufferL, float* bufferR, int32_t blockSize)
+{
+    if (!onOff)
+        return;
+
+    constexpr float invControlBlock = 1.0f / (float)WF_CONTROL_BLOCK;
+
+    int32_t n = 0;
+    while (n < blockSize)
+    {
+        if (controlCounter == 0)
+        {
+            delayPrev = delayNext;
+            delayNext = calcModulation();
+            controlCounter = WF_CONTROL_BLOCK;
+        }
+
+        const int32_t seg = std::min(blockSize - n, (int32_t)controlCounter);
+        const float delayInc = (delayNext - delayPrev) * invControlBlock;
+        const float delayStart = delayPrev + delayInc * (float)(WF_CONTROL_BLOCK - controlCounter);
+
+        // Switching: keep the direct input of the segment for the crossfade
+        const Switch sw = state;
+        float directL[WF_CONTROL_BLOCK];
+        float directR[WF_CONTROL_BLOCK];
+        if (sw != Switch::On)
+        {
+            std::memcpy(directL, bufferL + n, seg * sizeof(float));
+            std::memcpy(directR, bufferR + n, seg * sizeof(float));
+        }
+
+        switch (interp)
+        {
+            case WowFlutterInterp::Linear:  processSegment<WowFlutterInterp::Linear>(bufferL + n, bufferR + n, seg, delayStart, delayInc); break;
+            case WowFlutterInterp::Allpass: processSegment<WowFlutterInterp::Allpass>(bufferL + n, bufferR + n, seg, delayStart, delayInc); break;
+            case WowFlutterInterp::Hermite:
+            default:                        processSegment<WowFlutterInterp::Hermite>(bufferL + n, bufferR + n, seg, delayStart, delayInc); break;
+        }
+
+        if (sw != Switch::On)
+            mixSwitch(bufferL + n, bufferR + n, directL, directR, seg);
+
+        controlCounter -= seg;
+        n += seg;
+
+        // Fade out finished: bypassed from here on
+        if (state == Switch::Off)
+            return;
+    }
+}
+
+void WowFlutterProcessor::mixSwitch(float* bufferL, float* bufferR,
+                                    const float* directL, const float* directR, int numSamples)
+{
+    if (state == Switch::Filling)
+    {
+        // Ring written, output still direct
+        std::memcpy(bufferL, directL, numSamples * sizeof(float));
+        std::memcpy(bufferR, directR, numSamples * sizeof(float));
+        fillLeft -= numSamples;
+        return;
+    }
+
+    // Delayed output weight: rises while fading in, falls while fading out
+    constexpr float invFade = 1.0f / (float)LATENCY_FADE_SAMPLES;
+    const bool fadingIn = state == Switch::FadingIn;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float g = 0.0f;
+        if (fadeLeft > 0)
+        {
+            --fadeLeft;
+            g = (float)fadeLeft * invFade;
+        }
+        if (fadingIn)
+            g = 1.0f - g;
+        bufferL[i] = directL[i] + g * (bufferL[i] - directL[i]);
+        bufferR[i] = directR[i] + g * (bufferR[i] - directR[i]);
+    }
+
+    if (fadeLeft == 0)
+    {
+        state = fadingIn ? Switch::On : Switch::Off;
+        onOff = fadingIn;
+    }
+}
@@ -1,5 +1,10 @@
 #include "TapeProcessor.h"
-#include <cstring> 
+#include "DaisyMemory.h"
+#include "DaisyDenormals.h"
+#include "DaisyTelemetry.h"
+#include "DaisyCycleCounter.h"
+#include <cstring>
+#include <cmath>
 
 void TapeProcessor::setDelayLinePointers(MakeupDelayLine* makeL, MakeupDelayLine* makeR,
                                          DryDelayLine* dryL, DryDelayLine* dryR)
@@ -16,120 +21,446 @@ void TapeProcessor::Init(float sampleRate, const TapeParams& params)
 {
     const int numChannels = 2;
     inputFilters.prepare(sampleRate, numChannels);
-    lossFilter.prepare(sampleRate);
+    lossFilter.prepare(sampleRate, params.loss_mode);   // IIR: zero latency until the next Init()
     degradeProcessor.prepare(sampleRate); // <--- ADDED PREPARE
+    hysteresis.prepare(sampleRate);
+    compression.prepare(sampleRate);
+    wowFlutter.prepare(sampleRate);
+    azimuth.prepare(sampleRate);
+    saturator.prepare(sampleRate);
+    chew.prepare(sampleRate);
+    dropout.prepare(sampleRate);
     
     // Init the Dry Delay objects via the pointers
     if (dryDelayL != nullptr)
-    {
         dryDelayL->Init();
-        dryDelayL->SetDelay(0.0f);
-    }
     if (dryDelayR != nullptr)
-    {
         dryDelayR->Init();
-        dryDelayR->SetDelay(0.0f);
-    }
+    dryTap.reset(0.0f);
 
+    cyclesPerSample = (float)CycleCounter::PerSecond() / sampleRate;
+    peakCycles[0] = peakCycles[1] = 0;
+
+    // First block polls, and sets the compensation delays from scratch
+    controlCountdown = 0;
+    latencySamples = -1.0f;
+
+    // Mix starts settled; the lines were just cleared, so a dry path needs no refill
+    mix.reset((int)(TAPE_MIX_RAMP_MS * 0.001f * sampleRate));
+    mix.setCurrentAndTargetValue(params.dryWet);
+    mixTarget = params.dryWet;
+    dryPrimeRemaining = 0;
+    plan = ProcessingPlan();
+    plan.dryPath = params.dryWet < 1.0f;
+    planDirty = true;
+
+    // Fresh modules: stage everything
+    stagedValid = false;
     updateParams(params);
 }
 
 void TapeProcessor::updateParams(const TapeParams& params)
 {
-    // Stage new parameters for each module.
+    requested = params;
+    stageParams(applyTier(params, tier));
+}
+
+void TapeProcessor::setQualityTier(QualityTier newTier)
+{
+    if (newTier == tier) return;
+    tier = newTier;
+
+    // Before Init() there is nothing to restage yet
+    if (stagedValid)
+        stageParams(applyTier(requested, tier));
+}
+
+TapeParams TapeProcessor::applyTier(const TapeParams& params, QualityTier tier)
+{
+    TapeParams p = params;
+
+    if (tier >= QualityTier::Reduced && p.hyst_solver == HysteresisSolver::NR4)
+        p.hyst_solver = HysteresisSolver::RK4;
+
+    if (tier >= QualityTier::Economy)
+    {
+        // Same latency as the FIR: the dry and makeup delays don't move
+        p.hyst_solver = HysteresisSolver::RK2;
+        if (p.loss_mode == LossFilterMode::FIR)
+            p.loss_mode = LossFilterMode::IIRAligned;
+        if (p.wf_interp == WowFlutterInterp::Hermite)
+            p.wf_interp = WowFlutterInterp::Linear;
+    }
+    return p;
+}
+
+float TapeProcessor::takePeakLoad()
+{
+    // The interrupt preempts the main thread, never the reverse: once the slot is
+    // flipped it only writes the other one, so no block is lost between the read
+    // and the clear
+    const int slot = peakSlot;
+    peakSlot = 1 - slot;
+    const uint32_t peak = peakCycles[slot];
+    peakCycles[slot] = 0;
+    return (float)peak / cyclesPerSample;
+}
+
+void TapeProcessor::stageParams(const TapeParams& params)
+{
+    // Stage new parameters for each module whose inputs changed.
     // Actual application happens at the top of processBlock() in interrupt context.
     // This avoids inconsistent parameters due to interruptions by the audio callback.
-    inputFilters.prepareParams(params.lowCutFreq, params.highCutFreq,
-                               params.filtersEnabled, params.makeupEnabled);
+    const TapeParams& old = staged;
+    const bool all = !stagedValid;
+
+    if (all || params.lowCutFreq != old.lowCutFreq || params.highCutFreq != old.highCutFreq
+            || params.filtersEnabled != old.filtersEnabled || params.makeupEnabled != old.makeupEnabled)
+        inputFilters.prepareParams(params.lowCutFreq, params.highCutFreq,
+                                   params.filtersEnabled, params.makeupEnabled);
+
+    if (all || params.comp_amount != old.comp_amount || params.comp_attack != old.comp_attack
+            || params.comp_release != old.comp_release || params.comp_enabled != old.comp_enabled)
+        compression.prepareParams(params.comp_amount, params.comp_attack,
+                                  params.comp_release, params.comp_enabled);
+
+    if (all || params.hyst_drive != old.hyst_drive || params.hyst_saturation != old.hyst_saturation
+            || params.hyst_bias != old.hyst_bias || params.hyst_enabled != old.hyst_enabled
+            || params.hyst_solver != old.hyst_solver)
+        hysteresis.prepareParams(params.hyst_drive, params.hyst_saturation,
+                                 params.hyst_bias, params.hyst_enabled, params.hyst_solver);
+
+    if (all || params.wf_wow_rate != old.wf_wow_rate || params.wf_wow_depth != old.wf_wow_depth
+            || params.wf_flutter_rate != old.wf_flutter_rate || params.wf_flutter_depth != old.wf_flutter_depth
+            || params.wf_drift != old.wf_drift || params.wf_enabled != old.wf_enabled
+            || params.wf_interp != old.wf_interp)
+        wowFlutter.prepareParams(params.wf_wow_rate, params.wf_wow_depth,
+                                 params.wf_flutter_rate, params.wf_flutter_depth,
+                                 params.wf_drift, params.wf_enabled, params.wf_interp);
+
+    if (all || params.speed != old.speed || params.spacing != old.spacing
+            || params.thickness != old.thickness || params.gap != old.gap
+            || params.loss_mode != old.loss_mode)
+        lossFilter.prepareParams(params.speed, params.spacing,
+                                 params.thickness, params.gap, params.loss_mode);
+
+    if (all || params.az_angle != old.az_angle || params.speed != old.speed
+            || params.az_enabled != old.az_enabled)
+        azimuth.prepareParams(params.az_angle, params.speed, params.az_enabled);
 
-    lossFilter.prepareParams(params.speed, params.spacing,
-                             params.thickness, params.gap);
+    if (all || params.sat_drive != old.sat_drive || params.sat_enabled != old.sat_enabled)
+        saturator.prepareParams(params.sat_drive, params.sat_enabled);
 
-    degradeProcessor.prepareParams(params.deg_depth, params.deg_amount,
-                                   params.deg_variance, params.deg_envelope,
-                                   params.deg_enabled, params.usePoint1x);
+    if (all || params.deg_depth != old.deg_depth || params.deg_amount != old.deg_amount
+            || params.deg_variance != old.deg_variance || params.deg_envelope != old.deg_envelope
+            || params.deg_enabled != old.deg_enabled || params.usePoint1x != old.usePoint1x)
+        degradeProcessor.prepareParams(params.deg_depth, params.deg_amount,
+                                       params.deg_variance, params.deg_envelope,
+                                       params.deg_enabled, params.usePoint1x);
+
+    if (all || params.chew_depth != old.chew_depth || params.chew_freq != old.chew_freq
+            || params.chew_variance != old.chew_variance || params.chew_enabled != old.chew_enabled)
+        chew.prepareParams(params.chew_depth, params.chew_freq,
+                           params.chew_variance, params.chew_enabled);
+
+    if (all || params.drop_depth != old.drop_depth || params.drop_freq != old.drop_freq
+            || params.drop_variance != old.drop_variance || params.drop_enabled != old.drop_enabled)
+        dropout.prepareParams(params.drop_depth, params.drop_freq,
+                              params.drop_variance, params.drop_enabled);
 
     dryWet = params.dryWet;
+
+    staged = params;
+    stagedValid = true;
+}
+
+void TapeProcessor::runControlWorker()
+{
+    inputFilters.runWorker();
+    lossFilter.runWorker();
+    compression.runWorker();
+    hysteresis.runWorker();
+    degradeProcessor.runWorker();
+    azimuth.runWorker();
+    saturator.runWorker();
+    chew.runWorker();
+    dropout.runWorker();
 }
 
+void TapeProcessor::setControlInterval(int samples)
+{
+    controlInterval = samples > 0 ? samples : 0;
+    controlCountdown = 0;
+}
+
+DAISYTAPE_ITCM void TapeProcessor::controlTick()
+{
+    // Staged parameter sets
+    bool changed = false;
+    changed |= inputFilters.applyParams();
+    changed |= lossFilter.applyParams();
+    changed |= degradeProcessor.applyParams();
+    changed |= hysteresis.applyParams();
+    changed |= compression.applyParams();
+    changed |= wowFlutter.applyParams();
+    changed |= azimuth.applyParams();
+    changed |= saturator.applyParams();
+    changed |= chew.applyParams();
+    changed |= dropout.applyParams();
+
+    const float target = dryWet;
+    if (target != mixTarget)
+    {
+        mixTarget = target;
+        changed = true;
+    }
+
+    // Wow/flutter, chew and dropout leave the plan once their switch-off fade has run out
+    changed |= plan.wowFlutter != wowFlutter.isActive();
+    changed |= plan.chew != chew.isActive();
+    changed |= plan.dropout != dropout.isActive();
+
+    if (changed || planDirty)
+        rebuildPlan();
 
-void TapeProcessor::processBlock(const float* inL,
+    // Total latency of the wet path. It only moves when a module is switched on or
+    // off, i.e. right after an applyParams() above
+    float totalLatency = 0.0f;
+
+    // The Loss Filter (FIR) introduces significant latency (Order/2)
+    totalLatency += lossFilter.getLatencySamples();
+
+    // Compression has no lookahead (zero latency), kept here so the sum stays complete
+    totalLatency += compression.getLatencySamples();
+
+    // Wow & flutter modulates around a fixed centre delay
+    totalLatency += wowFlutter.getLatencySamples();
+
+    // The saturator's ADAA averages over the last sample step: half a sample
+    totalLatency += saturator.getLatencySamples();
+
+    // Compensate in whole samples: a fractional tap on the (linear) dry and makeup
+    // lines would lowpass them, down to a null at Nyquist for half a sample. Half a
+    // sample of misalignment only dips the dry/wet sum near Nyquist (-3 dB at fs/2)
+    totalLatency = std::round(totalLatency);
+
+    if (totalLatency == latencySamples)
+        return;
+    const bool first = latencySamples < 0.0f;
+    latencySamples = totalLatency;
+
+    // Makeup path and main dry path follow the wet one. Their taps crossfade to the new
+    // delay (a jump splices two unrelated points of the signal and clicks), unless
+    // nobody hears the dry lines: fully wet, refilling, or just cleared by Init()
+    inputFilters.setMakeupDelay(totalLatency);
+    if (first || !plan.dryPath || dryPrimeRemaining > 0)
+        dryTap.reset(totalLatency);
+    else
+        dryTap.setTarget(totalLatency);
+}
+
+DAISYTAPE_ITCM void TapeProcessor::rebuildPlan()
+{
+    planDirty = false;
+
+    // Bypassed stages aren't called at all. Every stage works in place, so a skipped
+    // one is exactly a no-op (the azimuth only copies when in != out)
+    plan.inputFilters = inputFilters.isActive();
+    plan.compression  = compression.isActive();
+    plan.hysteresis   = hysteresis.isActive();
+    plan.chew         = chew.isActive();
+    plan.degrade      = degradeProcessor.isActive();
+    plan.dropout      = dropout.isActive();
+    plan.wowFlutter   = wowFlutter.isActive();
+    plan.saturator    = saturator.isActive();
+    plan.lossFilter   = lossFilter.isActive();
+    plan.azimuth      = azimuth.isActive();
+    plan.makeup       = inputFilters.isMakeupActive();
+
+    // The dry path runs while any dry is audible, ramps included
+    const bool needDry = mixTarget < 1.0f || mix.getCurrentValue() < 1.0f;
+    if (needDry && !plan.dryPath)
+    {
+        // The dry lines stood still while fully wet and hold old audio: refill them
+        // for one latency (plus the interpolation tap) before letting any dry through
+        dryPrimeRemaining = (int)latencySamples + 2;
+    }
+    else if (!needDry)
+    {
+        dryPrimeRemaining = 0;
+    }
+    plan.dryPath = needDry;
+
+    if (dryPrimeRemaining == 0)
+        mix.setTargetValue(mixTarget);
+}
+
+DAISYTAPE_ITCM void TapeProcessor::processBlock(const float* inL,
                                  const float* inR,
                                  float* outL,
                                  float* outR,
                                  int32_t blockSize)
 {
-    // 1. Apply any staged parameter updates — safe here since we're in interrupt context
-    inputFilters.applyParams();
-    lossFilter.applyParams();
-    degradeProcessor.applyParams();
+    // No subnormal slow paths anywhere in the chain (decay tails, silent inputs)
+    ScopedFlushToZero flushDenormals;
+    const uint32_t blockStart = CycleCounter::Now();
 
-    // 2. Store dry signal and copy input to our internal wet buffer
-    for (int32_t i = 0; i < blockSize; i++)
+    // 1. Apply any staged parameter updates — safe here since we're in interrupt context.
+    // Polled once per control interval, so small blocks don't pay for it every callback
+    controlCountdown -= blockSize;
+    if (controlCountdown <= 0)
     {
-        dryBufferL[i] = inL[i];
-        dryBufferR[i] = inR[i];
-        bufferL[i]    = inL[i];
-        bufferR[i]    = inR[i];
+        controlCountdown = controlInterval;
+        controlTick();
     }
 
-    // --- 3. WET SIGNAL PATH ---
+    // 2. Copy input to our internal wet buffer, and store the dry signal if it is heard
+    if (plan.dryPath)
+    {
+        for (int32_t i = 0; i < blockSize; i++)
+        {
+            dryBufferL[i] = inL[i];
+            dryBufferR[i] = inR[i];
+            bufferL[i]    = inL[i];
+            bufferR[i]    = inR[i];
+        }
+    }
+    else
+    {
+        for (int32_t i = 0; i < blockSize; i++)
+        {
+            bufferL[i] = inL[i];
+            bufferR[i] = inR[i];
+        }
+    }
+
+    // --- 3. WET SIGNAL PATH --- (stages bypassed in the plan are skipped)
 
     // A. Input Filters
-    inputFilters.processBlock(bufferL, bufferR, blockSize);
+    if (plan.inputFilters)
+        inputFilters.processBlock(bufferL, bufferR, blockSize);
+
+    // B + C. Compression, then hysteresis (tape magnetisation), fused into one loop
+    // with the RK2 solver. With either one bypassed, or another solver, the chain runs
+    // a block pass per stage
+    if (plan.compression || plan.hysteresis)
+        compHyst.processBlock(bufferL, bufferR, blockSize);
 
-    // B. Degrade Processor
-    degradeProcessor.processBlock(bufferL, bufferR, blockSize);
+    // C2. Chew (random HF loss bursts)
+    if (plan.chew)
+        chew.processBlock(bufferL, bufferR, blockSize);
 
-    // C. Loss Filter (Head simulation)
-    // Note: In original structure, this was last, but without Hysteresis/Compression,
-    // we place it here. It modifies bufferL/bufferR in place.
-    lossFilter.processBlock(bufferL, bufferR, bufferL, bufferR, blockSize);
+    // D. Degrade Processor
+    if (plan.degrade)
+        degradeProcessor.processBlock(bufferL, bufferR, blockSize);
+
+    // D2. Dropout (random level dips)
+    if (plan.dropout)
+        dropout.processBlock(bufferL, bufferR, blockSize);
+
+    // E. Wow & Flutter
+    if (plan.wowFlutter)
+        wowFlutter.processBlock(bufferL, bufferR, blockSize);
+
+    // E2. Saturator (ADAA tanh, when the hysteresis stage is too expensive)
+    if (plan.saturator)
+        saturator.processBlock(bufferL, bufferR, blockSize);
+
+    // F. Loss Filter (Head simulation)
+    // It modifies bufferL/bufferR in place.
+    if (plan.lossFilter)
+        lossFilter.processBlock(bufferL, bufferR, bufferL, bufferR, blockSize);
+
+    // G. Azimuth (Inter-channel head offset)
+    if (plan.azimuth)
+        azimuth.processBlock(bufferL, bufferR, bufferL, bufferR, blockSize);
 
     // --- 4. LATENCY COMPENSATION ---
-    latencyCompensation(blockSize);
+    if (plan.dryPath)
+        latencyCompensation(blockSize);
 
     // --- 5. MAKEUP GAIN PATH ---
     // Must happen AFTER latency compensation to align with the delayed wet signal
-    inputFilters.processBlockMakeup(bufferL, bufferR, blockSize);
+    if (plan.makeup)
+        inputFilters.processBlockMakeup(bufferL, bufferR, blockSize);
 
     // --- 6. FINAL MIX ---
     dryWetMix(outL, outR, blockSize);
-}
-
-void TapeProcessor::latencyCompensation(int32_t blockSize)
-{
-    // 1. Calculate total latency from all wet path modules
-    float totalLatency = 0.0f;
-    
-    // The Loss Filter (FIR) introduces significant latency (Order/2)
-    totalLatency += lossFilter.getLatencySamples();
-    
-    // Future: Add latency from Oversampling/Compression here
-    // totalLatency += compression.getLatencySamples();
 
-    // 2. Set delay for InputFilters' makeup path
-    inputFilters.setMakeupDelay(totalLatency);
+    // Worst block for the governor (and the telemetry record)
+    const uint32_t cycles = CycleCounter::Elapsed(blockStart);
+    const uint32_t perSample = cycles / (uint32_t)blockSize;
+    const int slot = peakSlot;
+    if (perSample > peakCycles[slot])
+        peakCycles[slot] = perSample;
 
-    // 3. Set delay for the main Dry Path
-    if (dryDelayL != nullptr) dryDelayL->SetDelay(totalLatency);
-    if (dryDelayR != nullptr) dryDelayR->SetDelay(totalLatency);
+#if DAISYTAPE_TELEMETRY
+    uint32_t clips = 0;
+    for (int32_t i = 0; i < blockSize; i++)
+        clips += (std::fabs(outL[i]) >= 1.0f) + (std::fabs(outR[i]) >= 1.0f);
+    Telemetry::endBlock(cycles, clips);
+#endif
+}
 
-    // 4. Process the dry buffer through the delay
+DAISYTAPE_ITCM void TapeProcessor::latencyCompensation(int32_t blockSize)
+{
+    // The tap follows controlTick() whenever the wet path latency changes.
+    // Process the dry buffer through the delay
     if (dryDelayL != nullptr && dryDelayR != nullptr)
     {
         for (int32_t i = 0; i < blockSize; i++)
         {
+            dryTap.tick();
             dryDelayL->Write(dryBufferL[i]);
             dryDelayR->Write(dryBufferR[i]);
-            dryBufferL[i] = dryDelayL->Read();
-            dryBufferR[i] = dryDelayR->Read();
+            dryBufferL[i] = dryTap.read(*dryDelayL);
+            dryBufferR[i] = dryTap.read(*dryDelayR);
+        }
+    }
+
+    // Lines refilled after a fully wet stretch: the mix may start moving
+    if (dryPrimeRemaining > 0)
+    {
+        dryPrimeRemaining -= blockSize;
+        if (dryPrimeRemaining <= 0)
+        {
+            dryPrimeRemaining = 0;
+            planDirty = true;
         }
     }
 }
 
-void TapeProcessor::dryWetMix(float* outL, float* outR, int32_t blockSize)
+DAISYTAPE_ITCM void TapeProcessor::dryWetMix(float* outL, float* outR, int32_t blockSize)
 {
+    // Fully wet: the mix is a plain copy of the wet buffer
+    if (!plan.dryPath)
+    {
+        for (int32_t i = 0; i < blockSize; i++)
+        {
+            outL[i] = bufferL[i];
+            outR[i] = bufferR[i];
+        }
+        return;
+    }
+
+    // Ramping: per-sample gains. The end of a ramp may drop the dry path
+    if (mix.isSmoothing())
+    {
+        for (int32_t i = 0; i < blockSize; i++)
+        {
+            const float wet = mix.getNextValue();
+            outL[i] = (dryBufferL[i] * (1.0f - wet)) + (bufferL[i] * wet);
+            outR[i] = (dryBufferR[i] * (1.0f - wet)) + (bufferR[i] * wet);
+        }
+        if (!mix.isSmoothing())
+            planDirty = true;
+        return;
+    }
+
+    // Settled: both gains are constant for the block
+    const float wet = mix.getCurrentValue();
+    const float dry = 1.0f - wet;
+
     for (int32_t i = 0; i < blockSize; i++)
     {
         float wetL = bufferL[i];
@@ -138,7 +469,7 @@ void TapeProcessor::dryWetMix(float* outL, float* outR, int32_t blockSize)
         float dryL = dryBufferL[i];
         float dryR = dryBufferR[i];
 
-        outL[i] = (dryL * (1.0f - dryWet)) + (wetL * dryWet);
-        outR[i] = (dryR * (1.0f - dryWet)) + (wetR * dryWet);
+        outL[i] = (dryL * dry) + (wetL * wet);
+        outR[i] = (dryR * dry) + (wetR * wet);
     }
-}
\ No newline at end of file
+}
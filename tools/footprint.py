@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Per-module RAM / flash footprint from a GNU ld map file.
+
+Usage: python3 tools/footprint.py build/DaisyTape.map
+
+Every allocated input section is attributed to the memory region (from the map's
+"Memory Configuration" table) that holds its run address. Sections whose output
+section has a different load address (initialised data, ITCM code) are also
+counted in the load region, marked "(load)" in the region totals.
+Modules are our own object files (one per src/*.cpp); archive members are grouped
+per library (libdaisy, libdaisysp, libc, ...).
+"""
+
+import os
+import re
+import sys
+from collections import defaultdict
+
+HEX = r"0x[0-9a-fA-F]+"
+REGION_RE = re.compile(r"^(\S+)\s+(" + HEX + r")\s+(" + HEX + r")")
+OUTPUT_RE = re.compile(r"^(\.\S+|\S+)\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?")
+OUTPUT_NAME_RE = re.compile(r"^(\.\S+)\s*$")
+OUTPUT_CONT_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?\s*$")
+INPUT_RE = re.compile(r"^ (\S+)\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$")
+INPUT_NAME_RE = re.compile(r"^ (\S+)\s*$")
+INPUT_CONT_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$")
+
+# Output sections that don't occupy target memory (ITCM starts at 0x0 like these do)
+NON_ALLOC = (".debug", ".comment", ".ARM.attributes", ".stab", ".gnu.attributes")
+
+
+def module_name(path):
+    """build/DaisyTape.o -> DaisyTape, .../libdaisy.a(system.o) -> libdaisy"""
+    m = re.match(r"^(.*)\((.*)\)$", path)
+    if m:
+        return os.path.splitext(os.path.basename(m.group(1)))[0]
+    return os.path.splitext(os.path.basename(path))[0]
+
+
+def parse(lines):
+    regions = []
+    i = 0
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = REGION_RE.match(lines[i])
+        if m and m.group(1) not in ("Name", "*default*"):
+            regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+        i += 1
+
+    def region_of(addr):
+        for name, origin, length in regions:
+            if origin <= addr < origin + length:
+                return name
+        return None
+
+    usage = defaultdict(lambda: defaultdict(int))     # module -> region -> bytes
+    load_delta = 0                                     # LMA - VMA of the current output section
+    alloc = True                                       # current output section is in target memory
+    pending_output = None
+    pending_input = None
+
+    for line in lines[i:]:
+        if pending_output is not None:
+            m = OUTPUT_CONT_RE.match(line)
+            pending_output = None
+            if m:
+                load_delta = int(m.group(3), 16) - int(m.group(1), 16) if m.group(3) else 0
+                continue
+        if pending_input is not None:
+            name = pending_input
+            pending_input = None
+            m = INPUT_CONT_RE.match(line)
+            if m and alloc:
+                add_section(usage, region_of, load_delta, name, m.group(1), m.group(2), m.group(3))
+                continue
+
+        if line.startswith("."):
+            alloc = not line.startswith(NON_ALLOC)
+            m = OUTPUT_RE.match(line)
+            if m:
+                load_delta = int(m.group(4), 16) - int(m.group(2), 16) if m.group(4) else 0
+            elif OUTPUT_NAME_RE.match(line):
+                pending_output = line.strip()
+            continue
+
+        m = INPUT_RE.match(line)
+        if m and alloc:
+            add_section(usage, region_of, load_delta, m.group(1), m.group(2), m.group(3), m.group(4))
+            continue
+        m = INPUT_NAME_RE.match(line)
+        if m and not m.group(1).startswith("*"):
+            pending_input = m.group(1)
+
+    return regions, usage
+
+
+def add_section(usage, region_of, load_delta, name, addr, size, path):
+    addr, size = int(addr, 16), int(size, 16)
+    if size == 0:
+        return
+    path = path.strip()
+    if path.startswith("0x") or path.startswith("*"):
+        return      # symbol line or fill, not an input section
+    region = region_of(addr)
+    if region is None:
+        return      # debug / non-allocated
+    mod = module_name(path)
+    usage[mod][region] += size
+    if load_delta:
+        load_region = region_of(addr + load_delta)
+        if load_region and load_region != region:
+            usage[mod][load_region + " (load)"] += size
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    with open(sys.argv[1]) as f:
+        regions, usage = parse(f.read().splitlines())
+    if not regions:
+        sys.exit("no memory regions in " + sys.argv[1])
+
+    columns = [c for c in sorted({r for m in usage.values() for r in m},
+                                 key=lambda c: ([n for n, _, _ in regions].index(c.split()[0]), c))]
+    width = max([len(m) for m in usage] + [8])
+
+    print("%-*s" % (width, "module") + "".join("%16s" % c for c in columns))
+    totals = defaultdict(int)
+    for mod in sorted(usage, key=lambda m: -sum(usage[m].values())):
+        print("%-*s" % (width, mod) + "".join("%16d" % usage[mod].get(c, 0) for c in columns))
+        for c in columns:
+            totals[c] += usage[mod].get(c, 0)
+    print("%-*s" % (width, "total") + "".join("%16d" % totals[c] for c in columns))
+
+    print()
+    for name, origin, length in regions:
+        used = totals.get(name, 0) + totals.get(name + " (load)", 0)
+        if used:
+            print("%-10s %8d / %8d bytes (%5.1f%%)" % (name, used, length, 100.0 * used / length))
+
+
+if __name__ == "__main__":
+    main()
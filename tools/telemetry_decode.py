@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Decode the per-block telemetry printed by the firmware (DaisyTelemetry.h).
+
+Usage:
+  python3 tools/telemetry_decode.py [log file, default stdin] [options]
+  e.g. screen/minicom capture, or: cat /dev/ttyACM0 | python3 tools/telemetry_decode.py
+
+Lines starting with "@T " carry 8-byte little-endian records as hex:
+  uint32 cycles, uint16 seq, uint8 events, uint8 clips
+Everything else in the log is passed through untouched with --passthrough.
+
+Prints a summary (blocks, dropped records, cycles and CPU load per block, event
+and clip counts) every --interval blocks and at the end, or one CSV row per block
+with --csv.
+
+seq is 16 bits and wraps every 65536 blocks (~5.5 s at block 4). It is unwrapped
+into a running block number (the CSV "block" column) by assuming fewer than 65536
+records go missing between two received ones. The one ambiguous case the stream
+does flag, a full ring (overflow bit) with a whole number of wraps dropped, counts
+as 65536 dropped.
+"""
+
+import argparse
+import struct
+import sys
+
+TAG = "@T "
+RECORD = struct.Struct("<IHBB")
+SEQ_MOD = 1 << 16
+OVERFLOW = 1 << 7
+
+EVENTS = [
+    (1 << 0, "params"),
+    (1 << 1, "loss_xfade"),
+    (1 << 2, "filter_fade"),
+    (1 << 3, "degrade_cook"),
+    (OVERFLOW, "overflow"),
+]
+
+
+class SeqTracker:
+    """Unwraps the 16-bit seq into a running block number."""
+
+    def __init__(self):
+        self.last = None
+        self.block = 0
+
+    def next(self, seq, events):
+        """Takes the next record's seq, returns the records dropped before it."""
+        if self.last is None:
+            gap = 0
+            self.block = seq
+        else:
+            gap = (seq - self.last - 1) % SEQ_MOD
+            if gap == 0 and events & OVERFLOW:
+                gap = SEQ_MOD
+            self.block += gap + 1
+        self.last = seq
+        return gap
+
+
+class Summary:
+    def __init__(self, budget):
+        self.budget = budget
+        self.reset()
+
+    def reset(self):
+        self.blocks = 0
+        self.dropped = 0
+        self.total = 0
+        self.worst = 0
+        self.clips = 0
+        self.events = {name: 0 for _, name in EVENTS}
+
+    def add(self, cycles, events, clips, gap):
+        self.blocks += 1
+        self.dropped += gap
+        self.total += cycles
+        self.worst = max(self.worst, cycles)
+        self.clips += clips
+        for bit, name in EVENTS:
+            if events & bit:
+                self.events[name] += 1
+
+    def line(self):
+        if not self.blocks:
+            return "no records"
+        avg = self.total / self.blocks
+        text = "blocks %d dropped %d | cycles avg %.0f max %d" % (self.blocks, self.dropped, avg, self.worst)
+        if self.budget:
+            text += " (%.1f%% / %.1f%%)" % (100.0 * avg / self.budget, 100.0 * self.worst / self.budget)
+        text += " | clips %d | " % self.clips
+        text += " ".join("%s %d" % (name, n) for name, n in self.events.items())
+        return text
+
+
+def records(stream, passthrough):
+    for raw in stream:
+        line = raw.strip()
+        if not line.startswith(TAG):
+            if passthrough and line:
+                print(line)
+            continue
+        data = bytes.fromhex(line[len(TAG):])
+        for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+            yield RECORD.unpack_from(data, off)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", nargs="?", help="captured serial log (default: stdin)")
+    ap.add_argument("--csv", action="store_true", help="one row per block instead of summaries")
+    ap.add_argument("--interval", type=int, default=12000, help="blocks per summary line (default 12000, 1 s at block 4)")
+    ap.add_argument("--block-size", type=int, default=4, help="audio block size, for the CPU load (default 4)")
+    ap.add_argument("--cpu-hz", type=float, default=480e6, help="core clock (default 480 MHz)")
+    ap.add_argument("--fs", type=float, default=48000.0, help="sample rate (default 48 kHz)")
+    ap.add_argument("--passthrough", action="store_true", help="echo non-telemetry lines")
+    args = ap.parse_args()
+
+    stream = open(args.log) if args.log else sys.stdin
+    budget = args.cpu_hz * args.block_size / args.fs
+    window, overall = Summary(budget), Summary(budget)
+    tracker = SeqTracker()
+
+    if args.csv:
+        print("block,seq,cycles,load_pct,clips," + ",".join(name for _, name in EVENTS) + ",dropped_before")
+
+    for cycles, seq, events, clips in records(stream, args.passthrough):
+        gap = tracker.next(seq, events)
+        if args.csv:
+            print("%d,%d,%d,%.2f,%d,%s,%d" % (tracker.block, seq, cycles, 100.0 * cycles / budget, clips,
+                                              ",".join("1" if events & bit else "0" for bit, _ in EVENTS), gap))
+            continue
+        window.add(cycles, events, clips, gap)
+        overall.add(cycles, events, clips, gap)
+        if window.blocks >= args.interval:
+            print(window.line())
+            window.reset()
+
+    if not args.csv:
+        if window.blocks:
+            print(window.line())
+        print("total: " + overall.line())
+
+
+if __name__ == "__main__":
+    main()